@@ -1,161 +1,123 @@
 #include <stdlib.h>
-#include <malloc.h>
+#include <algorithm>
 #include "bbtracker.h"
 
 bb_tracker_t::bb_tracker_t ()
 {
 
   bb_id = 0;
+  bbtrace = NULL;
 
+  interval_size = bb_interval;
   first_interval = 1;
-  interval_sum=0; 
-  
+
   dyn_inst=0;
   total_inst= 0;
-  total_calls= 0;
 
 }
 
+bb_tracker_t::~bb_tracker_t ()
+{
+  if (bbtrace)
+    pclose(bbtrace);
+}
 
 
-void bb_tracker_t::init_bb_tracker (char* dir_name, char* out_name, uint64_t m_interval_size)
+void bb_tracker_t::init_bb_tracker (const char* dir_name, const char* out_name, uint64_t m_interval_size)
 {
-  int64_t i;
-
   outdir = dir_name;
   outfile = out_name;
   interval_size = m_interval_size;
 
-  /* initialize hash ptr table */
-  for (i=0; i<bb_size; i++)
-    bb_hash[i] = NULL;
-
-}
-
-
-bb_node_ptr bb_tracker_t::create_bb_node (uint64_t pc, uint64_t num_inst)
-{
-  bb_node_ptr temp;
-
-  temp = (bb_node_ptr) malloc(sizeof(bb_node));
-  
-  if (temp == NULL) {
-    fprintf(stderr,"OUT OF MEMORY\n");
-    exit(1);
-  }
-
-  temp->pc = pc;
-  temp->bb_id = bb_id++;
-  temp->count = num_inst;
-  temp->next = NULL;
-
-  return temp;
+  /* initialize hash table */
+  bb_node empty = {bb_empty_pc, 0};
+  bb_hash.assign(bb_size, empty);
+  bb_hash_bits = 0;
+  while ((1UL << bb_hash_bits) < bb_hash.size())
+    bb_hash_bits++;
 }
 
 
-void bb_tracker_t::append_bb_node (bb_node_ptr m_bb_node, bb_node_ptr head)
+/* Insert a new basic block at the given (empty) slot. Returns its bb_id. */
+uint64_t bb_tracker_t::new_bb_node (size_t slot, uint64_t pc)
 {
-  /* Append assumes head is non null. */
-
-  while (head->next != NULL) 
-    head = head->next;                                              
-
-  head->next = m_bb_node;
+  uint64_t id = bb_id++;
+  bb_hash[slot].pc = pc;
+  bb_hash[slot].bb_id = id;
+  bb_count.push_back(0);
+
+  if (2 * bb_id > bb_hash.size())
+    grow_bb_hash();
+  return id;
 }
 
 
-/* Search for bb_node with pc, if found return 1, otherwise 
-   return 0 */
-int bb_tracker_t::find_bb_node (bb_node_ptr head, uint64_t pc, uint64_t num_inst)
+void bb_tracker_t::grow_bb_hash ()
 {
-
-  if (head != NULL) {
-    while ((head->next != NULL) && (head->pc!=pc)) {
-      head = head->next;
-    }
-    
-    if ((head != NULL) && (head->pc == pc)) {
-      head->count += num_inst;
-      return 1;
+  std::vector<bb_node> old;
+  old.swap(bb_hash);
+
+  bb_node empty = {bb_empty_pc, 0};
+  bb_hash.assign(2 * old.size(), empty);
+  bb_hash_bits++;
+
+  size_t mask = bb_hash.size() - 1;
+  for (size_t i = 0; i < old.size(); i++) {
+    if (old[i].pc != bb_empty_pc) {
+      size_t slot = ((old[i].pc >> 1) * 0x9e3779b97f4a7c15ULL) >> (64 - bb_hash_bits);
+      while (bb_hash[slot].pc != bb_empty_pc)
+        slot = (slot + 1) & mask;
+      bb_hash[slot] = old[i];
     }
   }
-  return 0;
-} 
-
-void bb_tracker_t::print_list (bb_node_ptr head, uint64_t array[]) 
-{
-  do {
-    array[head->bb_id] = head->count;
-
-    /* clear stats */
-    head->count = 0;
-    head = head->next;
-  } while(head != NULL);
 }
 
-void bb_tracker_t::print_bb_hash (bb_node_ptr hash[])
-{
-  uint64_t i;
-  uint64_t bb_array[bb_id];
 
-  /* initialize array for sorting bb according to bb_id */
-  for(i=0; i<bb_id; i++) {
-    bb_array[i] = 0;
-  }
+/* End of an interval: record its basic block vector, and clear stats. */
+void bb_tracker_t::print_bb_hash ()
+{
+  std::sort(bb_touched.begin(), bb_touched.end());
 
-  for(i=0; i<bb_size; i++) {
-    if (hash[i] != NULL)
-      print_list(hash[i], bb_array);
+  bbv_t bbv;
+  bbv.reserve(bb_touched.size());
+  for (size_t i = 0; i < bb_touched.size(); i++) {
+    bbv.push_back(std::make_pair(bb_touched[i], bb_count[bb_touched[i]]));
+    bb_count[bb_touched[i]] = 0;
   }
+  bb_touched.clear();
 
   if (first_interval) {
     first_interval = 0;
-    sprintf( finalname, "gzip -c > %s/%s.bb.gz", outdir, outfile );
-    bbtrace = popen(finalname,"w");
+    std::string cmd = "gzip -c > " + outdir + "/" + outfile + ".bb.gz";
+    bbtrace = popen(cmd.c_str(), "w");
   }
 
-  fprintf(bbtrace,"T");
- 
-  for(i=0; i<bb_id; i++) { 
-    if(bb_array[i] > 0) {
-      fprintf( bbtrace, ":%" PRIu64 ":%" PRIu64 "   ", i+1, bb_array[i]);
-    }
+  if (bbtrace) {
+    fprintf(bbtrace,"T");
+
+    for (size_t i = 0; i < bbv.size(); i++)
+      fprintf( bbtrace, ":%" PRIu64 ":%" PRIu64 "   ", (uint64_t)bbv[i].first+1, bbv[i].second);
+
+    fprintf( bbtrace, "\n");
   }
 
-  fprintf( bbtrace, "\n");
-  fflush( bbtrace );
+  intervals.push_back(bbv);
 }
 
 
-void bb_tracker_t::bb_tracker(uint64_t pc, uint64_t num_inst)
+void bb_tracker_t::finish ()
 {
-  /* key into bb-hash based on pc of last inst in bb*/
-  uint64_t bb_key = (pc>>2)%bb_size;
-
-  /* Increment bb with the number of instructions it contains */
-  if (!find_bb_node(bb_hash[bb_key], pc, num_inst)) {
-
-    /* new bb, need to create node for it */
-    bb_node_ptr temp = create_bb_node(pc, num_inst);
+  if (2 * dyn_inst >= interval_size)
+    print_bb_hash();
 
-    if (bb_hash[bb_key] == NULL) {                                           
-      bb_hash[bb_key] = temp;                                                
-    } else {
-      append_bb_node(temp, bb_hash[bb_key]);                                     
-    } 
-  }
-
-  dyn_inst += num_inst;
-  total_inst += num_inst;
-
-  /* if reached end of interval, dump stats and decrement counter */
-  if (dyn_inst > interval_size) {
-    dyn_inst -= interval_size;
-    print_bb_hash(bb_hash);
+  if (bbtrace) {
+    pclose(bbtrace);
+    bbtrace = NULL;
   }
 }
 
-void bb_tracker_t::set_interval_size(uint64_t m_interval_size)
+
+void bb_tracker_t::set_interval_size(size_t m_interval_size)
 {
   interval_size = m_interval_size;
 }
@@ -3,65 +3,103 @@
 
 #include <cinttypes>
 #include <stdio.h>
+#include <string>
+#include <vector>
+#include <utility>
 
-/* Initializes interval size, output directory and output name, 
-   as well as the basic block hash table */
+/* Collects basic block vectors (BBVs) for the SimPoint methodology: for each
+   interval of interval_size instructions, the number of instructions executed
+   in each basic block. The BBVs are kept in memory (for pick_simpoints()) and
+   written to <outdir>/<outfile>.bb.gz in the SimPoint input format. */
 
-/* Size of basic block hash table. Should be increased for very 
-   large programs (greater than 1 million basic blocks) */
-#define bb_size 1000000
+/* Initial size of the basic block hash table (grows as needed). */
+#define bb_size (1 << 16)
 #define bb_interval 100000000
 
-/* basic block element */ 
-typedef struct node {
-  uint64_t count;
-  uint64_t bb_id;
+/* Basic block vector of one interval: (bb_id, instruction count) pairs, by bb_id. */
+typedef std::vector<std::pair<uint32_t, uint64_t> > bbv_t;
+
+/* basic block hash table element: the pc of the last instruction in the
+   basic block, and the basic block's id (ids are dense, in order of first
+   execution) */
+typedef struct {
   uint64_t pc;
-  struct node * next;
+  uint64_t bb_id;
 } bb_node;
 
-typedef  bb_node * bb_node_ptr;
+#define bb_empty_pc (~(uint64_t)0)
 
 class bb_tracker_t{
 
   private:
-    bb_node_ptr bb_hash[bb_size];
-    
-    uint64_t bb_id_pool = bb_size;
-    uint64_t bb_id;
+    /* Open addressing (linear probing), power-of-2 size, at most half full. */
+    std::vector<bb_node> bb_hash;
+    unsigned bb_hash_bits;
+
+    uint64_t bb_id;                     /* number of basic blocks seen */
+    std::vector<uint64_t> bb_count;     /* this interval's count, by bb_id */
+    std::vector<uint32_t> bb_touched;   /* bb_ids with a nonzero count this interval */
 
     FILE* bbtrace;
-    char finalname[450];
-    char *outdir;                                                                
-    char *outfile;                                                               
-    
-    uint64_t interval_size; 
+    std::string outdir;
+    std::string outfile;
+
+    uint64_t interval_size;
     uint64_t first_interval;
-    uint64_t interval_sum; 
-    
+
     uint64_t dyn_inst;
     uint64_t total_inst;
-    uint64_t total_calls;
 
-    bb_node_ptr create_bb_node (uint64_t pc, uint64_t num_inst);
-    void append_bb_node (bb_node_ptr m_bb_node, bb_node_ptr head);
-    int find_bb_node (bb_node_ptr head, uint64_t pc, uint64_t num_inst);
-    void print_list (bb_node_ptr head, uint64_t array[]);
-    void print_bb_hash (bb_node_ptr hash[]);
+    std::vector<bbv_t> intervals;
+
+    uint64_t new_bb_node (size_t slot, uint64_t pc);
+    void grow_bb_hash ();
+    void print_bb_hash ();
 
   public:
 
     bb_tracker_t ();
     ~bb_tracker_t();
 
-    void init_bb_tracker (char* m_dir_name, char* m_out_name, uint64_t m_interval_size);
+    void init_bb_tracker (const char* m_dir_name, const char* m_out_name, uint64_t m_interval_size);
     void set_interval_size(size_t m_interval_size);
- 
+    uint64_t get_interval_size() { return interval_size; }
 
-    /* Called at each CTRL op, marking the end of a basic block.  The pc of the last 
-     instruction indexes into the basic block hash, and the counter is inceremented 
+    /* Called at each CTRL op, marking the end of a basic block.  The pc of the last
+     instruction indexes into the basic block hash, and the counter is inceremented
      by the number of instructions in the basic block. */
     void bb_tracker (uint64_t m_pc, uint64_t m_num_inst);
+
+    /* Ends profiling: the last, partial interval is kept if it is at least
+       half an interval. */
+    void finish ();
+
+    const std::vector<bbv_t>& get_intervals() { return intervals; }
 };
 
+inline void bb_tracker_t::bb_tracker(uint64_t pc, uint64_t num_inst)
+{
+  /* key into bb-hash based on pc of last inst in bb */
+  size_t mask = bb_hash.size() - 1;
+  size_t slot = ((pc >> 1) * 0x9e3779b97f4a7c15ULL) >> (64 - bb_hash_bits);
+  while ((bb_hash[slot].pc != pc) && (bb_hash[slot].pc != bb_empty_pc))
+    slot = (slot + 1) & mask;
+
+  uint64_t id = ((bb_hash[slot].pc == pc) ? bb_hash[slot].bb_id : new_bb_node(slot, pc));
+
+  /* Increment bb with the number of instructions it contains */
+  if (!bb_count[id])
+    bb_touched.push_back(id);
+  bb_count[id] += num_inst;
+
+  dyn_inst += num_inst;
+  total_inst += num_inst;
+
+  /* if reached end of interval, dump stats and decrement counter */
+  if (dyn_inst >= interval_size) {
+    dyn_inst -= interval_size;
+    print_bb_hash();
+  }
+}
+
 #endif
@@ -50,7 +50,7 @@
 /* #undef RISCV_ENABLE_HISTOGRAM */
 
 /* Enable Basic Block Vector generation for simpoint tool */
-/* #undef RISCV_ENABLE_SIMPOINT */
+#define RISCV_ENABLE_SIMPOINT /**/
 
 /* Define if subproject MCPPBS_SPROJ_NORM is enabled */
 #define SOFTFLOAT_ENABLED /**/
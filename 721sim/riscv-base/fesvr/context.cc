@@ -1,12 +1,60 @@
 #include "context.h"
 #include <assert.h>
 #include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
 
 static __thread context_t* cur;
 
+#ifdef USE_STACK_SWITCH
+// Saves the callee-saved registers, MXCSR and the x87 control word on the
+// current stack, stores the stack pointer to *save_sp, then restores the same
+// state from new_sp. context_start is where a fresh context first "returns" to:
+// it calls wrapper(r12) through r13.
+extern "C" void context_stack_switch(void** save_sp, void* new_sp);
+extern "C" void context_start();
+asm(".text\n"
+    ".globl context_stack_switch\n"
+    ".type context_stack_switch,@function\n"
+    "context_stack_switch:\n"
+    "  pushq %rbp\n"
+    "  pushq %rbx\n"
+    "  pushq %r12\n"
+    "  pushq %r13\n"
+    "  pushq %r14\n"
+    "  pushq %r15\n"
+    "  subq $8, %rsp\n"
+    "  stmxcsr (%rsp)\n"
+    "  fnstcw 4(%rsp)\n"
+    "  movq %rsp, (%rdi)\n"
+    "  movq %rsi, %rsp\n"
+    "  ldmxcsr (%rsp)\n"
+    "  fldcw 4(%rsp)\n"
+    "  addq $8, %rsp\n"
+    "  popq %r15\n"
+    "  popq %r14\n"
+    "  popq %r13\n"
+    "  popq %r12\n"
+    "  popq %rbx\n"
+    "  popq %rbp\n"
+    "  ret\n"
+    ".size context_stack_switch, .-context_stack_switch\n"
+    ".globl context_start\n"
+    ".type context_start,@function\n"
+    "context_start:\n"
+    "  movq %r12, %rdi\n"
+    "  callq *%r13\n"
+    "  ud2\n"
+    ".size context_start, .-context_start\n");
+
+static const size_t STACK_SIZE = 64*1024;
+#endif
+
 context_t::context_t()
   : creator(NULL), func(NULL), arg(NULL),
-#ifndef USE_UCONTEXT
+#if defined(USE_STACK_SWITCH)
+    sp(NULL), stack(NULL)
+#elif !defined(USE_UCONTEXT)
     mutex(PTHREAD_MUTEX_INITIALIZER),
     cond(PTHREAD_COND_INITIALIZER), flag(0)
 #else
@@ -20,6 +68,10 @@ void context_t::wrapper(context_t* ctx)
 {
   ctx->creator->switch_to();
   ctx->func(ctx->arg);
+#ifdef USE_STACK_SWITCH
+  // There is no uc_link to fall back to.
+  abort();
+#endif
 }
 #else
 void* context_t::wrapper(void* a)
@@ -39,7 +91,24 @@ void context_t::init(void (*f)(void*), void* a)
   arg = a;
   creator = current();
 
-#ifdef USE_UCONTEXT
+#if defined(USE_STACK_SWITCH)
+  // Build the frame context_stack_switch() pops: FP control, r15..r12, rbx,
+  // rbp, and the return address. context_start is entered with a 16-byte
+  // aligned stack, as a call site would have it.
+  stack = new char[STACK_SIZE];
+  uint64_t* top = (uint64_t*)(((uintptr_t)stack + STACK_SIZE) & ~(uintptr_t)15) - 2;
+  uint64_t* frame = top - 8;
+  frame[0] = 0x037F00001F80;                  // x87 control word, MXCSR
+  frame[1] = 0;                               // r15
+  frame[2] = 0;                               // r14
+  frame[3] = (uint64_t)&context_t::wrapper;   // r13
+  frame[4] = (uint64_t)this;                  // r12
+  frame[5] = 0;                               // rbx
+  frame[6] = 0;                               // rbp
+  frame[7] = (uint64_t)&context_start;        // return address
+  sp = frame;
+  switch_to();
+#elif defined(USE_UCONTEXT)
   assert(getcontext(context.get()) == 0);
   context->uc_link = creator->context.get();
   context->uc_stack.ss_size = 64*1024;
@@ -62,12 +131,19 @@ void context_t::init(void (*f)(void*), void* a)
 context_t::~context_t()
 {
   assert(this != cur);
+#ifdef USE_STACK_SWITCH
+  delete [] stack;
+#endif
 }
 
 void context_t::switch_to()
 {
   assert(this != cur);
-#ifdef USE_UCONTEXT
+#if defined(USE_STACK_SWITCH)
+  context_t* prev = cur;
+  cur = this;
+  context_stack_switch(&prev->sp, sp);
+#elif defined(USE_UCONTEXT)
   context_t* prev = cur;
   cur = this;
   assert(swapcontext(prev->context.get(), context.get()) == 0);
@@ -89,7 +165,9 @@ context_t* context_t::current()
   if (cur == NULL)
   {
     cur = new context_t;
-#ifdef USE_UCONTEXT
+#if defined(USE_STACK_SWITCH)
+    // The stack pointer is saved on the first switch away.
+#elif defined(USE_UCONTEXT)
     assert(getcontext(cur->context.get()) == 0);
 #else
     cur->thread = pthread_self();
@@ -12,6 +12,12 @@
 # include <memory>
 #endif
 
+// swapcontext() saves and restores the signal mask, a system call, on
+// every switch. On x86-64, switch stacks directly instead.
+#if defined(USE_UCONTEXT) && defined(__x86_64__)
+# define USE_STACK_SWITCH
+#endif
+
 class context_t
 {
  public:
@@ -24,7 +30,11 @@ class context_t
   context_t* creator;
   void (*func)(void*);
   void* arg;
-#ifdef USE_UCONTEXT
+#if defined(USE_STACK_SWITCH)
+  void* sp;     // saved stack pointer while switched out
+  char* stack;  // stack of a context created by init()
+  static void wrapper(context_t*);
+#elif defined(USE_UCONTEXT)
   std::unique_ptr<ucontext_t> context;
   static void wrapper(context_t*);
 #else
@@ -153,3 +153,11 @@ void device_list_t::tick()
   for (size_t i = 0; i < num_devices; i++)
     devices[i]->tick();
 }
+
+bool device_list_t::busy()
+{
+  for (size_t i = 0; i < num_devices; i++)
+    if (devices[i]->busy())
+      return true;
+  return false;
+}
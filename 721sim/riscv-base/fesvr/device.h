@@ -40,6 +40,8 @@ class device_t
   virtual ~device_t() {}
   virtual const char* identity() = 0;
   virtual void tick() {}
+  // True if tick() has work to do (e.g., a request waiting on the host).
+  virtual bool busy() { return false; }
 
   void handle_command(command_t cmd);
 
@@ -65,6 +67,7 @@ class bcd_t : public device_t
   bcd_t();
   const char* identity() { return "bcd"; }
   void tick();
+  bool busy() { return !pending_reads.empty(); }
 
  private:
   void handle_read(command_t cmd);
@@ -110,6 +113,7 @@ class device_list_t
   void register_device(device_t* dev);
   void handle_command(command_t cmd);
   void tick();
+  bool busy();
 
  private:
   std::vector<device_t*> devices;
@@ -56,7 +56,7 @@ void htif_t::set_chroot(const char* where)
 }
 
 htif_t::htif_t(const std::vector<std::string>& args)
-  : exitcode(0), mem(this), seqno(1), started(false), stopped(false),
+  : exitcode(0), mem(this), seqno(1), started(false), stopped(false), host_idle(false),
     _mem_mb(0), _num_cores(0), sig_addr(0), sig_len(0)
 {
   signal(SIGINT, &handle_signal);
@@ -97,6 +97,10 @@ htif_t::htif_t(const std::vector<std::string>& args)
       set_chroot(arg.substr(strlen("+chroot=")).c_str());
     else if (arg.find("+target-cwd=") == 0)
       target_init_cwd = arg.substr(strlen("+target-cwd="));
+    else if (arg.find("+syscall-record=") == 0)
+      syscall_proxy->record_syscalls(arg.c_str() + strlen("+syscall-record="));
+    else if (arg.find("+syscall-replay=") == 0)
+      syscall_proxy->replay_syscalls(arg.c_str() + strlen("+syscall-replay="));
   }
 
   if (target_init_cwd.empty())
@@ -317,8 +321,14 @@ int htif_t::run()
   {
     for (uint32_t coreid = 0; coreid < num_cores(); coreid++)
     {
+      host_idle = true;
+      for (auto& q : fromhost)
+        host_idle = host_idle && q.empty();
+      host_idle = host_idle && !device_list.busy();
+
       if (auto tohost = write_cr(coreid, 30, 0))
       {
+        host_idle = false;
         command_t cmd(this, tohost, fromhost_callbacks[coreid], coreid);
         device_list.handle_command(cmd);
       }
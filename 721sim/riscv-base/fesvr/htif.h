@@ -21,6 +21,23 @@ class htif_t
   int run();
   bool done();
   int exit_code();
+  // The target has written its exit code to tohost.
+  bool exited() { return exitcode != 0; }
+
+  // True while the host is only polling tohost: nothing is queued for
+  // fromhost and no device has work pending. Until the target writes
+  // tohost, ticking the target just swaps a zero tohost for zero.
+  bool idle() { return host_idle; }
+
+  // Syscalls are served from a log recorded by an earlier run
+  // (+syscall-replay=<file>), see syscall_main_t.
+  bool replaying_syscalls() { return syscall_proxy->replaying_syscalls(); }
+  // Skip the logged syscalls served up to the given instruction count.
+  void skip_replayed_syscalls(uint64_t instret) { syscall_proxy->skip_replayed_syscalls(instret); }
+  // The host fds of the target's open files, indexed by target fd (-1: closed).
+  const std::vector<int>& target_fds() { return syscall_proxy->target_fds(); }
+  // Instruction count of the core, which keys the syscall log.
+  virtual uint64_t instret(uint32_t coreid) { return 0; }
 
   virtual reg_t read_cr(uint32_t coreid, uint16_t regnum);
   virtual reg_t write_cr(uint32_t coreid, uint16_t regnum, reg_t val);
@@ -52,6 +69,7 @@ class htif_t
   seqno_t seqno;
   bool started;
   bool stopped;
+  bool host_idle;
   uint32_t _mem_mb;
   uint32_t _num_cores;
   std::vector<std::string> hargs;
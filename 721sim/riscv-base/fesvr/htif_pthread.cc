@@ -13,7 +13,7 @@ void htif_pthread_t::thread_main(void* arg)
 }
 
 htif_pthread_t::htif_pthread_t(const std::vector<std::string>& args)
-  : htif_t(args)
+  : htif_t(args), th_data(FIFO_SIZE), ht_data(FIFO_SIZE)
 {
   target = context_t::current();
   host.init(thread_main, this);
@@ -29,21 +29,21 @@ ssize_t htif_pthread_t::read(void* buf, size_t max_size)
     target->switch_to();
     
   size_t s = std::min(max_size, th_data.size());
-  std::copy(th_data.begin(), th_data.begin() + s, (char*)buf);
-  th_data.erase(th_data.begin(), th_data.begin() + s);
+  memcpy(buf, th_data.data(), s);
+  th_data.pop(s);
 
   return s;
 }
 
 ssize_t htif_pthread_t::write(const void* buf, size_t size)
 {
-  ht_data.insert(ht_data.end(), (const char*)buf, (const char*)buf + size);
+  memcpy(ht_data.append(size), buf, size);
   return size;
 }
 
 void htif_pthread_t::send(const void* buf, size_t size)
 {
-  th_data.insert(th_data.end(), (const char*)buf, (const char*)buf + size);
+  memcpy(th_data.append(size), buf, size);
 }
 
 void htif_pthread_t::recv(void* buf, size_t size)
@@ -60,7 +60,14 @@ bool htif_pthread_t::recv_nonblocking(void* buf, size_t size)
     return false;
   }
 
-  std::copy(ht_data.begin(), ht_data.begin() + size, (char*)buf);
-  ht_data.erase(ht_data.begin(), ht_data.begin() + size);
+  memcpy(buf, ht_data.data(), size);
+  ht_data.pop(size);
   return true;
 }
+
+const char* htif_pthread_t::recv_view(size_t size)
+{
+  while (ht_data.size() < size)
+    host.switch_to();
+  return ht_data.data();
+}
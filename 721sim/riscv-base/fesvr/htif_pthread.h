@@ -5,7 +5,52 @@
 
 #include "htif.h"
 #include "context.h"
-#include <deque>
+#include <memory>
+#include <assert.h>
+#include <string.h>
+
+// Fixed-capacity byte FIFO between the host and the target.
+// The two sides take turns (a request, then its response), so the FIFO
+// drains on every exchange and rewinds to the start of its storage.
+// Pending bytes are therefore contiguous and can be used in place.
+class htif_fifo_t
+{
+ public:
+  htif_fifo_t(size_t capacity)
+    : buf(new char[capacity]), cap(capacity), head(0), tail(0) {}
+
+  size_t size() const { return tail - head; }
+  const char* data() const { return &buf[head]; }
+
+  // Append 'n' bytes and return a pointer to them, for the caller to fill.
+  char* append(size_t n)
+  {
+    if (tail + n > cap)
+    {
+      memmove(&buf[0], &buf[head], size());
+      tail -= head;
+      head = 0;
+    }
+    assert(tail + n <= cap);
+    char* p = &buf[tail];
+    tail += n;
+    return p;
+  }
+
+  void pop(size_t n)
+  {
+    assert(n <= size());
+    head += n;
+    if (head == tail)
+      head = tail = 0;
+  }
+
+ private:
+  std::unique_ptr<char[]> buf;
+  size_t cap;
+  size_t head;
+  size_t tail;
+};
 
 class htif_pthread_t : public htif_t
 {
@@ -18,6 +63,20 @@ class htif_pthread_t : public htif_t
   void recv(void* buf, size_t size);
   bool recv_nonblocking(void* buf, size_t size);
 
+  // Zero-copy variants of send() and recv().
+  // send_buf() returns space for 'size' bytes to be sent, to be filled in
+  // before control returns to the host.
+  // recv_view() waits for 'size' bytes and returns them in place; they stay
+  // valid until consumed with recv_done().
+  char* send_buf(size_t size) { return th_data.append(size); }
+  const char* recv_view(size_t size);
+  void recv_done(size_t size) { ht_data.pop(size); }
+
+  // Make the calling thread the target side of the host/target handoff.
+  // The target may be ticked from a thread other than the one that
+  // constructed it, as long as only one thread ticks it at a time.
+  void set_target_thread() { target = context_t::current(); }
+
  protected:
   // host interface
   virtual ssize_t read(void* buf, size_t max_size);
@@ -29,8 +88,10 @@ class htif_pthread_t : public htif_t
  private:
   context_t host;
   context_t* target;
-  std::deque<char> th_data;
-  std::deque<char> ht_data;
+  // Large enough for any packet: a header plus chunk_max_size() bytes.
+  static const size_t FIFO_SIZE = 16*1024;
+  htif_fifo_t th_data;
+  htif_fifo_t ht_data;
 
   static void thread_main(void* htif);
 };
@@ -27,7 +27,7 @@ const char* const* option_parser_t::parse(const char* const* argv0)
       {
         const char* optarg = &opt[2];
         if (str_match)
-          optarg = opt[2+slen] ? &opt[3+slen] : *(++argv);
+          optarg = opt[2+slen] ? &opt[3+slen] : (it->arg ? *(++argv) : 0);
         if (optarg && !*optarg)
           optarg = 0;
         if (optarg && it->arg == 0)
@@ -13,6 +13,7 @@ class rfb_t : public device_t
   rfb_t(int display = 0);
   ~rfb_t();
   void tick();
+  bool busy() { return true; } // refreshes the frame buffer every tick
   std::string name() { return "RISC-V"; }
   const char* identity() { return "rfb"; }
 
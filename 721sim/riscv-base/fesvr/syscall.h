@@ -23,6 +23,8 @@ class fds_t
   reg_t alloc(int fd);
   void dealloc(reg_t fd);
   int lookup(reg_t fd);
+  // Host fds, indexed by target fd (-1: closed).
+  const std::vector<int>& host_fds() { return fds; }
  private:
   std::vector<int> fds;
 };
@@ -35,6 +37,13 @@ class syscall_t : public device_t
   virtual void enable_strace(const char* output_path);
   virtual void dump_std_out_err(const char* stdout_dump_path, const char* stderr_dump_path);
   virtual void init_target_cwd(const char* cwd);
+  // Syscall record/replay: only the main syscall device (syscall_bypass.h) does it.
+  virtual void record_syscalls(const char* log_path) {}
+  virtual void replay_syscalls(const char* log_path) {}
+  virtual void skip_replayed_syscalls(uint64_t instret) {}
+  virtual bool replaying_syscalls() { return false; }
+  // The host fds of the target's open files, indexed by target fd (-1: closed).
+  const std::vector<int>& target_fds() { return fds.host_fds(); }
 
  private:
   strace* m_strace;
@@ -52,6 +61,9 @@ class syscall_t : public device_t
 
   void handle_syscall(command_t cmd);
   void dispatch(addr_t mm);
+  // Called by dispatch() after a proxied syscall: magicmem[0] is its number,
+  // magicmem[1..7] its arguments, and ret its result.
+  virtual void syscall_dispatched(const reg_t* magicmem, reg_t ret) {}
   std::string do_chroot(const char* fn);
   std::string undo_chroot(const char* fn);
 
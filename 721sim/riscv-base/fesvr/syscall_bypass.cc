@@ -1,4 +1,9 @@
 #include "syscall_bypass.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
 
 static syscall_main_t *upstream = nullptr;
 
@@ -25,7 +30,7 @@ void memif_tap_t::write(addr_t addr, size_t len, const void *bytes) {
   m_listener.on_mem_write(addr, len, bytes);
 }
 
-syscall_mirror_t::syscall_mirror_t(htif_t *htif) : syscall_t(htif) {
+syscall_mirror_t::syscall_mirror_t(htif_t *htif) : syscall_t(htif), main_device(nullptr) {
   cores_queued_service_seq.resize(CORE_SEQ_QUEUE_MAX);
   register_command(
     0,
@@ -39,15 +44,20 @@ syscall_mirror_t::syscall_mirror_t(htif_t *htif) : syscall_t(htif) {
 }
 
 void syscall_mirror_t::notify_syscall_sequence(syscall_service_sequence_t *new_seq) {
+  std::lock_guard<std::mutex> l(queue_lock);
   cores_queued_service_seq[new_seq->seq_coreid].push(new_seq);
 }
 
 void syscall_mirror_t::syscall_handler_mirror(command_t cmd) {
   // perform action according to the seq in the queue for this cpu core
   auto coreid = cmd.get_coreid();
-  assert(!cores_queued_service_seq[coreid].empty());
-  auto service_seq = cores_queued_service_seq[coreid].front();
-  cores_queued_service_seq[coreid].pop();
+  syscall_service_sequence_t *service_seq;
+  {
+    std::lock_guard<std::mutex> l(queue_lock);
+    assert(!cores_queued_service_seq[coreid].empty());
+    service_seq = cores_queued_service_seq[coreid].front();
+    cores_queued_service_seq[coreid].pop();
+  }
   assert(service_seq->seq_coreid == coreid);
 
   if (service_seq->seq_payload != cmd.payload()) {
@@ -74,6 +84,10 @@ void syscall_mirror_t::syscall_handler_mirror(command_t cmd) {
   syscall_service_sequence_t::free(service_seq);
 }
 
+bool syscall_mirror_t::replaying_syscalls() {
+  return main_device && main_device->replaying_syscalls();
+}
+
 void syscall_mirror_t::enable_strace(const char *output_path) {}
 
 void syscall_mirror_t::dump_std_out_err(const char *stdout_dump_path, const char *stderr_dump_path) {}
@@ -92,25 +106,38 @@ syscall_main_t::syscall_main_t(htif_t *htif) : syscall_t(htif), memif_tap(htif,
     "syscall_handler_main"
   );
   active_sequence = nullptr;
+  record_log = nullptr;
+  replay_log = nullptr;
+  replay_pending = false;
 }
 
 void syscall_main_t::register_mirror(syscall_mirror_t *mirror) {
   mirrors.push_back(mirror);
+  mirror->set_main_device(this);
 }
 
 void syscall_main_t::syscall_handler_main(command_t cmd) {
-  auto recording_sequence = !mirrors.empty();
+  auto recording_sequence = !mirrors.empty() || record_log;
+  uint64_t instret = htif->instret(cmd.get_coreid());
 
   if (recording_sequence) {
     assert(active_sequence == nullptr);
     active_sequence = new syscall_service_sequence_t(cmd.payload(), cmd.get_coreid(), mirrors.size() + 1);
   }
 
-  handle_syscall(cmd);
+  reg_t respond = 1;
+  if (replay_log) {
+    respond = replay_syscall(cmd);
+  } else {
+    handle_syscall(cmd);
+  }
 
   if (recording_sequence) {
-    active_sequence->seq_respond = 1;
+    active_sequence->seq_respond = respond;
     active_sequence->seq_final_htif_exitcode = htif->exitcode;
+    if (record_log) {
+      record_sequence(active_sequence, instret);
+    }
     for (auto &m : mirrors) {
       // broadcast the recorded sequence to all mirrors
       m->notify_syscall_sequence(active_sequence);
@@ -120,6 +147,26 @@ void syscall_main_t::syscall_handler_main(command_t cmd) {
   }
 }
 
+// Note which syscall this was, and keep what a sys_write wrote to stdout or
+// stderr (the buffer it read from target memory), for the syscall log.
+void syscall_main_t::syscall_dispatched(const reg_t *magicmem, reg_t ret) {
+  if (!active_sequence) {
+    return;
+  }
+  active_sequence->seq_syscall_no = magicmem[0];
+  active_sequence->seq_fd = magicmem[1];
+  if ((magicmem[0] == 64 /* sys_write */) && ((magicmem[1] == STDOUT_FILENO) || (magicmem[1] == STDERR_FILENO)) &&
+      ((sreg_t) ret > 0)) {
+    for (auto &t: active_sequence->seq_trans) {
+      if (!t->is_write && (t->taddr == magicmem[2])) {
+        size_t len = std::min((size_t) ret, t->len);
+        active_sequence->seq_output.assign(t->data, t->data + len);
+        break;
+      }
+    }
+  }
+}
+
 void syscall_main_t::on_mem_read(addr_t addr, size_t len, void *bytes) {
   if (active_sequence) {
     auto trans = new syscall_mem_transaction_t(addr, len, bytes, false);
@@ -133,3 +180,142 @@ void syscall_main_t::on_mem_write(addr_t addr, size_t len, const void *bytes) {
     active_sequence->seq_trans.push_back(trans);
   }
 }
+
+void syscall_main_t::record_syscalls(const char *log_path) {
+  record_log = fopen(log_path, "wb");
+  syscall_log_header_t hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  strcpy(hdr.magic, SYSCALL_LOG_MAGIC);
+  hdr.version = SYSCALL_LOG_VERSION;
+  if (!record_log || (fwrite(&hdr, sizeof(hdr), 1, record_log) != 1)) {
+    fprintf(stderr, "Fail to open [%s] for recording syscalls (%s).\n", log_path, strerror(errno));
+    exit(-1);
+  }
+}
+
+void syscall_main_t::record_sequence(const syscall_service_sequence_t *seq, uint64_t instret) {
+  syscall_log_record_t rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.instret = instret;
+  rec.payload = seq->seq_payload;
+  rec.respond = seq->seq_respond;
+  rec.exitcode = seq->seq_final_htif_exitcode;
+  rec.coreid = seq->seq_coreid;
+  rec.syscall_no = seq->seq_syscall_no;
+  rec.fd = seq->seq_fd;
+  rec.naccesses = seq->seq_trans.size();
+  // The target's output, so that a replay reproduces it.
+  rec.output_len = seq->seq_output.size();
+
+  bool ok = (fwrite(&rec, sizeof(rec), 1, record_log) == 1);
+  for (auto &t: seq->seq_trans) {
+    syscall_log_access_t a = {t->taddr, t->len, t->is_write, 0};
+    ok = ok && (fwrite(&a, sizeof(a), 1, record_log) == 1);
+    if (t->is_write) {
+      ok = ok && (fwrite(t->data, 1, t->len, record_log) == t->len);
+    }
+  }
+  if (rec.output_len) {
+    ok = ok && (fwrite(seq->seq_output.data(), 1, rec.output_len, record_log) == rec.output_len);
+  }
+  // Flushed per syscall: the log stays usable if the run is killed.
+  if (!ok || (fflush(record_log) != 0)) {
+    fprintf(stderr, "Fail to record syscall (%s).\n", strerror(errno));
+    exit(-1);
+  }
+}
+
+void syscall_main_t::replay_syscalls(const char *log_path) {
+  replay_log = fopen(log_path, "rb");
+  syscall_log_header_t hdr;
+  if (!replay_log || (fread(&hdr, sizeof(hdr), 1, replay_log) != 1)) {
+    fprintf(stderr, "Fail to open [%s] for replaying syscalls (%s).\n", log_path, strerror(errno));
+    exit(-1);
+  }
+  if (strcmp(hdr.magic, SYSCALL_LOG_MAGIC) || (hdr.version != SYSCALL_LOG_VERSION)) {
+    fprintf(stderr, "[%s] is not a version %d syscall log.\n", log_path, SYSCALL_LOG_VERSION);
+    exit(-1);
+  }
+}
+
+// Returns the next record of the replay log, whose accesses and output follow
+// in the log, or nullptr at the end of the log.
+const syscall_log_record_t *syscall_main_t::peek_replay_record() {
+  if (!replay_pending) {
+    replay_pending = (fread(&replay_next, sizeof(replay_next), 1, replay_log) == 1);
+  }
+  return replay_pending ? &replay_next : nullptr;
+}
+
+void syscall_main_t::read_replay_log(void *buf, size_t len) {
+  if (fread(buf, 1, len, replay_log) != len) {
+    throw std::runtime_error("Syscall replay fatal: log is truncated");
+  }
+}
+
+void syscall_main_t::skip_replayed_syscalls(uint64_t instret) {
+  if (!replay_log) {
+    return;
+  }
+
+  const syscall_log_record_t *rec;
+  while ((rec = peek_replay_record()) && (rec->instret <= instret)) {
+    uint64_t skip = rec->output_len;
+    for (uint32_t i = 0; i < rec->naccesses; i++) {
+      syscall_log_access_t a;
+      read_replay_log(&a, sizeof(a));
+      if (a.is_write) {
+        fseek(replay_log, a.len, SEEK_CUR);
+      }
+    }
+    fseek(replay_log, skip, SEEK_CUR);
+    replay_pending = false;
+  }
+}
+
+// Serve the syscall from the replay log: make its target memory accesses and
+// output, instead of running it on the host.
+reg_t syscall_main_t::replay_syscall(command_t cmd) {
+  const syscall_log_record_t *next = peek_replay_record();
+  if (!next) {
+    throw std::runtime_error("Syscall replay fatal: log exhausted");
+  }
+  if ((next->payload != cmd.payload()) || (next->coreid != cmd.get_coreid())) {
+    throw std::runtime_error("Syscall replay fatal: cmd.payload != logged payload");
+  }
+  syscall_log_record_t rec = *next;
+  replay_pending = false;
+
+  std::vector<uint8_t> data;
+  for (uint32_t i = 0; i < rec.naccesses; i++) {
+    syscall_log_access_t a;
+    read_replay_log(&a, sizeof(a));
+    data.resize(a.len);
+    if (a.is_write) {
+      read_replay_log(data.data(), a.len);
+      memif->write(a.addr, a.len, data.data());
+    } else {
+      memif->read(a.addr, a.len, data.data());
+    }
+  }
+  if (rec.output_len) {
+    data.resize(rec.output_len);
+    read_replay_log(data.data(), rec.output_len);
+    if (write(rec.fd, data.data(), rec.output_len) < 0) {
+      perror("syscall replay");
+    }
+  }
+  if (active_sequence) {
+    active_sequence->seq_syscall_no = rec.syscall_no;
+    active_sequence->seq_fd = rec.fd;
+    active_sequence->seq_output.assign(data.begin(), data.begin() + rec.output_len);
+  }
+
+  htif->exitcode = rec.exitcode;
+  if ((rec.payload & 1) && htif->exit_code()) {
+    std::cerr << "*** FAILED *** (tohost = " << htif->exit_code() << ")" << std::endl;
+  }
+
+  cmd.respond(rec.respond);
+  return rec.respond;
+}
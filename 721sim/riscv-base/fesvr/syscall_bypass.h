@@ -6,6 +6,9 @@
 #include "memif.h"
 #include <functional>
 #include <iostream>
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
 
 #define CORE_SEQ_QUEUE_MAX 8
 
@@ -32,12 +35,16 @@ public:
 
 struct syscall_service_sequence_t {
 private:
-  size_t ref_cnt;
+  // The main and mirror simulators may release a sequence from different threads.
+  std::atomic<size_t> ref_cnt;
 public:
   reg_t seq_payload;
   uint32_t seq_coreid;
   uint64_t seq_respond;
   int seq_final_htif_exitcode;
+  uint64_t seq_syscall_no;    // 0 for test pass/fail (tohost bit 0 set)
+  uint64_t seq_fd;            // first syscall argument
+  std::vector<uint8_t> seq_output;  // bytes a sys_write wrote to stdout/stderr
   std::vector<syscall_mem_transaction_t *> seq_trans;
 
   explicit syscall_service_sequence_t(reg_t seq_tohost, uint32_t seq_coreid, size_t ref_cnt) :
@@ -45,11 +52,14 @@ public:
     assert(ref_cnt != 0);
     seq_respond = 0;
     seq_final_htif_exitcode = 0;
+    seq_syscall_no = 0;
+    seq_fd = 0;
   };
 
   syscall_service_sequence_t(syscall_service_sequence_t &&o) noexcept:
-    ref_cnt(o.ref_cnt), seq_payload(o.seq_payload), seq_coreid(o.seq_coreid), seq_respond(o.seq_respond),
-    seq_final_htif_exitcode(o.seq_final_htif_exitcode), seq_trans(std::move(o.seq_trans)) {
+    ref_cnt(o.ref_cnt.load()), seq_payload(o.seq_payload), seq_coreid(o.seq_coreid), seq_respond(o.seq_respond),
+    seq_final_htif_exitcode(o.seq_final_htif_exitcode), seq_syscall_no(o.seq_syscall_no), seq_fd(o.seq_fd),
+    seq_output(std::move(o.seq_output)), seq_trans(std::move(o.seq_trans)) {
     o.seq_trans.clear();
     o.ref_cnt = 0;
   };
@@ -60,18 +70,52 @@ public:
     }
   }
 
+  // Each holder releases its reference exactly once; the last one deletes.
+  // A moved-from sequence (ref_cnt 0) owns nothing and must not be freed.
   static void free(syscall_service_sequence_t *&seq) {
-    if (seq->ref_cnt != 0) {
-      --seq->ref_cnt;
-    }
-
-    if (seq->ref_cnt == 0) {
+    assert(seq->ref_cnt.load() != 0);
+    if (seq->ref_cnt.fetch_sub(1) == 1) {
       delete seq;
     }
     seq = nullptr;
   }
 };
 
+// Binary syscall log (+syscall-record=<file>, +syscall-replay=<file>):
+// a syscall_log_header_t, then for each proxied syscall a syscall_log_record_t,
+// followed by its target memory accesses in order (each a syscall_log_access_t,
+// and the data for writes) and by the bytes it wrote to stdout/stderr, if any.
+// Reads are replayed too (their data is not logged), so the target sees the
+// same HTIF traffic as in the recorded run.
+#define SYSCALL_LOG_MAGIC   "721SYSL"
+#define SYSCALL_LOG_VERSION 2
+
+struct syscall_log_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct syscall_log_record_t {
+  uint64_t instret;      // instruction count of the core when the syscall was served
+  uint64_t payload;      // tohost
+  uint64_t respond;      // fromhost
+  int32_t exitcode;      // htif exit code after the syscall
+  uint32_t coreid;
+  uint64_t syscall_no;   // magicmem[0]; 0 for test pass/fail
+  uint64_t fd;           // first syscall argument (the fd for sys_write)
+  uint32_t naccesses;
+  uint32_t reserved;
+  uint64_t output_len;   // sys_write to stdout/stderr, else 0
+};
+
+struct syscall_log_access_t {
+  uint64_t addr;
+  uint64_t len;
+  uint32_t is_write;
+  uint32_t reserved;
+};
+
 class memif_tap_listener_t {
 public:
   virtual void on_mem_read(addr_t addr, size_t len, void *bytes) = 0;
@@ -92,18 +136,29 @@ private:
 
 };
 
+class syscall_main_t;
+
 class syscall_mirror_t : public syscall_t {
 private:
+  syscall_main_t *main_device;
   std::vector<
     std::queue<syscall_service_sequence_t *>
   > cores_queued_service_seq;
+  // Sequences are queued by the main simulator's thread and consumed by this one's.
+  std::mutex queue_lock;
 public:
   explicit syscall_mirror_t(htif_t *htif);
 
   void notify_syscall_sequence(syscall_service_sequence_t *new_seq);
 
+  void set_main_device(syscall_main_t *main) { main_device = main; }
+
   void syscall_handler_mirror(command_t cmd);
 
+  // The mirror replays whatever its main device serves, so it follows the
+  // main device's replay mode rather than having its own.
+  bool replaying_syscalls() override;
+
   void enable_strace(const char *output_path) override;
 
   void dump_std_out_err(const char *stdout_dump_path, const char *stderr_dump_path) override;
@@ -117,9 +172,29 @@ private:
   std::vector<syscall_mirror_t *> mirrors;
   syscall_service_sequence_t *active_sequence;
 
+  FILE *record_log;
+  FILE *replay_log;
+  syscall_log_record_t replay_next;
+  bool replay_pending;
+
+  void record_sequence(const syscall_service_sequence_t *seq, uint64_t instret);
+  const syscall_log_record_t *peek_replay_record();
+  void read_replay_log(void *buf, size_t len);
+  reg_t replay_syscall(command_t cmd);
+
 public:
   explicit syscall_main_t(htif_t *htif);
 
+  void record_syscalls(const char *log_path) override;
+
+  void replay_syscalls(const char *log_path) override;
+
+  void skip_replayed_syscalls(uint64_t instret) override;
+
+  bool replaying_syscalls() override { return replay_log != nullptr; }
+
+  void syscall_dispatched(const reg_t *magicmem, reg_t ret) override;
+
   void register_mirror(syscall_mirror_t *mirror);
 
   void syscall_handler_main(command_t cmd);
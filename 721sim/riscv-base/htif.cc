@@ -18,9 +18,10 @@
 extern bool logging_on;
 
 htif_isasim_t::htif_isasim_t(sim_t* _sim, const std::vector<std::string>& args)
-  : htif_pthread_t(args), sim(_sim), reset(true), seqno(1), checkpoint(NULL)
+  : htif_pthread_t(args), sim(_sim), reset(true), seqno(1), polled_tohost(0), checkpoint(NULL)
 {
     checkpointing_active = false;
+    direct_mem = false;
 }
 
 htif_isasim_t::~htif_isasim_t()
@@ -52,15 +53,29 @@ bool htif_isasim_t::tick()
   return true;
 }
 
-void htif_isasim_t::tick_once()
+// Returns false if tick() can be skipped without any architectural effect.
+// That is the case while the host is idle (see htif_t::idle()), it saw a zero
+// tohost in its last poll, and the target hasn't written tohost since: the
+// skipped tick would only swap a zero tohost for zero and poll again.
+// With more than one core, the host polls the cores round-robin, one per tick,
+// so ticks are never skipped.
+bool htif_isasim_t::needs_tick()
 {
-  packet_header_t hdr;
-  recv(&hdr, sizeof(hdr));
+  if (reset || !idle() || polled_tohost || (sim->num_cores() != 1))
+    return true;
+  return (sim->get_core(0)->get_state()->tohost != 0);
+}
+
+uint64_t htif_isasim_t::instret(uint32_t coreid)
+{
+  return sim->get_core(coreid)->get_state()->count;
+}
 
-  char buf[hdr.get_packet_size()];
-  memcpy(buf, &hdr, sizeof(hdr));
-  recv(buf + sizeof(hdr), hdr.get_payload_size());
-  packet_t p(buf);
+void htif_isasim_t::tick_once()
+{
+  // The packet is used in place, in the host-to-target FIFO.
+  packet_header_t hdr(recv_view(sizeof(packet_header_t)));
+  const char* payload = recv_view(hdr.get_packet_size()) + sizeof(hdr);
 
   assert(hdr.seqno == seqno);
 
@@ -81,7 +96,8 @@ void htif_isasim_t::tick_once()
       packet_header_t ack(HTIF_CMD_ACK, seqno, hdr.data_size, 0);
       send(&ack, sizeof(ack));
 
-      uint64_t buf[hdr.data_size];
+      // Load straight into the target-to-host FIFO, behind the ack.
+      uint64_t* buf = (uint64_t*)send_buf(hdr.data_size * sizeof(uint64_t));
       for (size_t i = 0; i < hdr.data_size; i++)
         buf[i] = sim->debug_mmu->load_uint64((hdr.addr+i)*HTIF_DATA_ALIGN);
 
@@ -92,15 +108,13 @@ void htif_isasim_t::tick_once()
         }
         *checkpoint << std::endl;
       }
-
-      send(buf, hdr.data_size * sizeof(buf[0]));
       break;
     }
     case HTIF_CMD_WRITE_MEM:
     {
       ifprintf(logging_on,stderr,"HTIF_CMD_WRITE_MEM seq no: %" PRIu8 "\n", seqno);
 
-      const uint64_t* buf = (const uint64_t*)p.get_payload();
+      const uint64_t* buf = (const uint64_t*)payload;
       for (size_t i = 0; i < hdr.data_size; i++)
         sim->debug_mmu->store_uint64((hdr.addr+i)*HTIF_DATA_ALIGN, buf[i]);
 
@@ -143,7 +157,7 @@ void htif_isasim_t::tick_once()
       processor_t* proc = sim->get_core(coreid);
       bool write = hdr.cmd == HTIF_CMD_WRITE_CONTROL_REG;
       if (write)
-        memcpy(&new_val, p.get_payload(), sizeof(new_val));
+        memcpy(&new_val, payload, sizeof(new_val));
 
       //fprintf(stderr,"HTIF_CMD_READ/WRITE_CONTROL_REG reg no: %" PRIreg " seq no: %" PRIu8 "\n",regno, seqno);
 
@@ -155,6 +169,7 @@ void htif_isasim_t::tick_once()
           break;
         case CSR_TOHOST & 0x1f:
           old_val = proc->get_state()->tohost;
+          polled_tohost = old_val;
           if (write)
             proc->get_state()->tohost = new_val;
           break;
@@ -190,9 +205,38 @@ void htif_isasim_t::tick_once()
     default:
       abort();
   }
+  recv_done(hdr.get_packet_size());
   seqno++;
 }
 
+void htif_isasim_t::start()
+{
+  direct_mem = true;
+  htif_pthread_t::start();
+  direct_mem = false;
+}
+
+void htif_isasim_t::read_chunk(addr_t taddr, size_t len, void* dst)
+{
+  if (!direct_mem) {
+    htif_pthread_t::read_chunk(taddr, len, dst);
+    return;
+  }
+  assert(taddr + len <= sim->memsz);
+  memcpy(dst, sim->mem + taddr, len);
+}
+
+void htif_isasim_t::write_chunk(addr_t taddr, size_t len, const void* src)
+{
+  if (!direct_mem) {
+    htif_pthread_t::write_chunk(taddr, len, src);
+    return;
+  }
+  assert(taddr + len <= sim->memsz);
+  memcpy(sim->mem + taddr, src, len);
+  sim->dirty_pages->set_range(taddr, len);
+}
+
 bool htif_isasim_t::done()
 {
   if (reset)
@@ -43,18 +43,29 @@ class htif_isasim_t : public htif_pthread_t
 public:
   htif_isasim_t(sim_t* _sim, const std::vector<std::string>& args);
   ~htif_isasim_t();
+  // Program loading and the boot-time memory setup in start() write the
+  // simulator's memory directly, instead of through WRITE_MEM packets.
+  void start();
   bool tick();
+  bool needs_tick();
+  uint64_t instret(uint32_t coreid);
   bool done();
   bool restore_checkpoint(std::istream& restore);
   void start_checkpointing(std::ostream& checkpoint_file);
   void stop_checkpointing();
 
+protected:
+  void read_chunk(addr_t taddr, size_t len, void* dst);
+  void write_chunk(addr_t taddr, size_t len, const void* src);
+
 private:
   sim_t* sim;
   bool reset;
   uint8_t seqno;
+  reg_t polled_tohost; // tohost returned by the last tohost swap
   void setup_replay_state(replay_pkt_t*);
   bool checkpointing_active;
+  bool direct_mem; // true while start() accesses memory directly
 
   //std::fstream* checkpoint;
   std::ostream* checkpoint;
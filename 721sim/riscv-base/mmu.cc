@@ -5,14 +5,14 @@
 #include "processor.h"
 
 mmu_t::mmu_t(char* _mem, size_t _memsz)
- : mem(_mem), memsz(_memsz), proc(NULL)
+ : mem(_mem), memsz(_memsz), dirty_pages(NULL), proc(NULL)
 {
   flush_tlb();
   debug_mmu = false;
 }
 
 mmu_t::mmu_t(char* _mem, size_t _memsz, bool _debug_mmu)
- : mem(_mem), memsz(_memsz), proc(NULL)
+ : mem(_mem), memsz(_memsz), dirty_pages(NULL), proc(NULL)
 {
   flush_tlb();
   debug_mmu = _debug_mmu; // Set flag to true if this is a debug MMU
@@ -65,12 +65,21 @@ void* mmu_t::refill_tlb(reg_t addr, reg_t bytes, bool store, bool fetch)
   reg_t pgbase = pte >> PGSHIFT << PGSHIFT;
   reg_t paddr = pgbase + pgoff;
 
+  // Stores only hit in the TLB on pages already marked dirty.
+  bool dirty = true;
+  if (dirty_pages) {
+    if (store)
+      dirty_pages->set(pgbase >> PGSHIFT);
+    else
+      dirty = dirty_pages->test(pgbase >> PGSHIFT);
+  }
+
   if (unlikely(tracer.interested_in_range(pgbase, pgbase + PGSIZE, store, fetch)))
     tracer.trace(paddr, bytes, store, fetch);
   else
   {
     tlb_load_tag[idx] = (pte_perm & PTE_UR) ? expected_tag : -1;
-    tlb_store_tag[idx] = (pte_perm & PTE_UW) ? expected_tag : -1;
+    tlb_store_tag[idx] = ((pte_perm & PTE_UW) && dirty) ? expected_tag : -1;
     tlb_insn_tag[idx] = (pte_perm & PTE_UX) ? expected_tag : -1;
     tlb_data[idx] = mem + pgbase - (addr & ~(PGSIZE-1));
   }
@@ -10,6 +10,7 @@
 #include "processor.h"
 #include "memtracer.h"
 #include <vector>
+#include <algorithm>
 #include "debug.h"
 
 // virtual memory configuration
@@ -28,6 +29,46 @@ const reg_t VA_BITS = VPN_BITS + PGSHIFT;
 //  insn_t insn;
 //};
 
+// One bit per page of target memory, e.g., to track which pages have been
+// written (see mmu_t::set_dirty_pages()).
+class page_bitmap_t
+{
+public:
+  page_bitmap_t(size_t _pages) : bits((_pages + 63) / 64, 0), pages(_pages) {}
+
+  size_t size() const { return pages; }
+  bool test(size_t page) const { return (bits[page >> 6] >> (page & 63)) & 1; }
+  void set(size_t page) { bits[page >> 6] |= (uint64_t)1 << (page & 63); }
+
+  // Set the bits of all pages overlapping [addr, addr+len).
+  void set_range(reg_t addr, size_t len)
+  {
+    if (len)
+      for (size_t page = addr >> PGSHIFT; page <= ((addr + len - 1) >> PGSHIFT); page++)
+        set(page);
+  }
+
+  void set_all()
+  {
+    for (size_t page = 0; page < pages; page++)
+      set(page);
+  }
+
+  void clear_all() { std::fill(bits.begin(), bits.end(), 0); }
+
+  size_t count() const
+  {
+    size_t n = 0;
+    for (size_t i = 0; i < bits.size(); i++)
+      n += __builtin_popcountll(bits[i]);
+    return n;
+  }
+
+private:
+  std::vector<uint64_t> bits;
+  size_t pages;
+};
+
 struct icache_entry_t {
   reg_t tag;
   reg_t pad;
@@ -193,9 +234,15 @@ public:
 
   void register_memtracer(memtracer_t*);
 
+  // Pages written through this MMU are marked in 'dirty' (NULL: no tracking).
+  // A page is marked on the store TLB refill that precedes its first store, so
+  // the TLB hit path is unchanged.
+  void set_dirty_pages(page_bitmap_t* dirty) { dirty_pages = dirty; flush_tlb(); }
+
 private:
   char* mem;
   size_t memsz;
+  page_bitmap_t* dirty_pages;
   processor_t* proc;
   memtracer_list_t tracer;
 
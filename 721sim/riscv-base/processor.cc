@@ -16,6 +16,7 @@
 #include <stdexcept>
 #include <algorithm>
 #include "debug.h"
+#include "bbtracker.h"
 
 #undef STATE
 #define STATE state
@@ -24,8 +25,12 @@ extern bool logging_on;
 
 processor_t::processor_t(sim_t* _sim, mmu_t* _mmu, uint32_t _id)
   : sim(_sim), mmu(_mmu), ext(NULL), disassembler(new disassembler_t),
-    id(_id), run(false), debug(false), serialized(false)
+    id(_id), run(false), debug(false), warming(false), serialized(false), pipe(NULL)
 {
+#ifdef RISCV_ENABLE_SIMPOINT
+  bbtracker = NULL;
+  bb_insts = 0;
+#endif
   reset(true);
   mmu->set_processor(this);
 
@@ -37,6 +42,9 @@ processor_t::processor_t(sim_t* _sim, mmu_t* _mmu, uint32_t _id)
 
 processor_t::~processor_t()
 {
+#ifdef RISCV_ENABLE_SIMPOINT
+  delete bbtracker;
+#endif
 #ifdef RISCV_ENABLE_HISTOGRAM
   if (histogram_enabled)
   {
@@ -142,6 +150,35 @@ void processor_t::set_histogram(bool value)
   histogram_enabled = value;
 }
 
+#ifdef RISCV_ENABLE_SIMPOINT
+// Basic block vectors are written to simpoint.bb.gz (simpoint.<id>.bb.gz
+// for cores other than core 0).
+void processor_t::set_simpoint(bool enable, size_t interval)
+{
+  delete bbtracker;
+  bbtracker = NULL;
+  bb_insts = 0;
+  if (enable) {
+    std::string name = "simpoint";
+    if (id)
+      name += "." + std::to_string(id);
+    bbtracker = new bb_tracker_t;
+    bbtracker->init_bb_tracker(".", name.c_str(), interval);
+  }
+}
+
+// A control transfer instruction (branch, jal, jalr) ends a basic block.
+inline void processor_t::track_bb(reg_t pc, insn_t insn)
+{
+  bb_insts++;
+  reg_t opcode = insn.bits() & 0x7f;
+  if ((opcode == 0x63) || (opcode == 0x6f) || (opcode == 0x67)) {
+    bbtracker->bb_tracker(pc, bb_insts);
+    bb_insts = 0;
+  }
+}
+#endif
+
 void processor_t::reset(bool value)
 {
 
@@ -233,10 +270,17 @@ static reg_t execute_insn(processor_t* p, reg_t pc, insn_fetch_t fetch)
   //  }
   //#endif
   //TODO: Push to debug buffer current PC, RS1, RS2 and all immediate values
+  reg_t rs1 = (unlikely(p->get_warming()) ? p->get_state()->XPR[fetch.insn.rs1()] : 0);
   reg_t npc = fetch.func(p, fetch.insn, pc);
+  if (unlikely(p->get_warming()))
+    p->warm(pc, fetch.insn, npc, rs1);
   //TODO: Push to debug buffer RD value and next PC
   commit_log(p->get_state(), pc, fetch.insn);
   p->update_histogram(pc);
+  #ifdef RISCV_ENABLE_SIMPOINT
+    if (unlikely(p->get_bb_tracker() != NULL))
+      p->track_bb(pc, fetch.insn);
+  #endif
   #ifdef RISCV_MICRO_CHECKER
     if(p->get_checker()){
 	    p->get_pipe()->push_instr_actual(fetch.insn, 0, 0, pc, npc, 0, 0);
@@ -17,6 +17,7 @@ class trap_t;
 class extension_t;
 class disassembler_t;
 class debug_buffer_t;
+class bb_tracker_t;
 
 struct serialize_t {};
 
@@ -79,6 +80,11 @@ public:
   bool get_debug();
   void set_checker(bool value);
   bool get_checker();
+  void set_warming(bool value) { warming = value; }
+  bool get_warming() { return warming; }
+  // Functional warming: called for each instruction executed while warming,
+  // with its pc, next pc, and rs1 value before it executed.
+  virtual void warm(reg_t pc, insn_t insn, reg_t npc, reg_t rs1) {}
   void set_proc_type(const char*);
   const char* get_proc_type();
   void set_histogram(bool value);
@@ -95,6 +101,11 @@ public:
   extension_t* get_extension() { return ext; }
   void yield_load_reservation() { state.load_reservation = (reg_t)-1; }
   virtual void update_histogram(size_t pc);
+#ifdef RISCV_ENABLE_SIMPOINT
+  void set_simpoint(bool enable, size_t interval);
+  bb_tracker_t* get_bb_tracker() { return bbtracker; }
+  void track_bb(reg_t pc, insn_t insn);
+#endif
 
   void register_insn(insn_desc_t);
   void register_extension(extension_t*);
@@ -115,6 +126,7 @@ protected:
   bool run; // !reset
   bool debug;
   bool checker;
+  bool warming;
   const char* proc_type;
   bool histogram_enabled;
   bool rv64;
@@ -124,6 +136,11 @@ protected:
 
   std::map<size_t,size_t> pc_histogram;
 
+#ifdef RISCV_ENABLE_SIMPOINT
+  bb_tracker_t* bbtracker; // basic block vector profiling (NULL: off)
+  size_t bb_insts;         // instructions so far in the current basic block
+#endif
+
   void serialize(); // collapse into defined architectural state
   void take_interrupt(); // take a trap if any interrupts are pending
   virtual reg_t take_trap(trap_t& t, reg_t epc); // take an exception
@@ -0,0 +1,177 @@
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <algorithm>
+#include "simpoint.h"
+
+// k-means: random initializations per k, and iteration limit.
+#define SIMPOINT_SEEDS      5
+#define SIMPOINT_ITERATIONS 100
+#define SIMPOINT_BIC_THRESHOLD 0.9
+
+typedef std::vector<double> point_t;
+
+static uint64_t splitmix64(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Projection matrix entry in [-1,1), for basic block 'bb' and dimension 'dim'.
+// Computed, rather than stored, as the number of basic blocks is open-ended.
+static double projection(uint32_t bb, unsigned dim)
+{
+  uint64_t r = splitmix64(((uint64_t)bb << 8) | dim);
+  return (double)(r >> 11) / (double)(1ULL << 52) - 1.0;
+}
+
+static double distance2(const point_t& a, const point_t& b)
+{
+  double d = 0;
+  for (size_t i = 0; i < a.size(); i++)
+    d += (a[i] - b[i]) * (a[i] - b[i]);
+  return d;
+}
+
+struct clustering_t {
+  std::vector<size_t> assign;
+  std::vector<point_t> centers;
+  double sse;
+};
+
+// k-means, seeded furthest-first from a random interval.
+static clustering_t kmeans(const std::vector<point_t>& points, size_t k, uint64_t seed)
+{
+  size_t n = points.size();
+  clustering_t c;
+  c.centers.push_back(points[splitmix64(seed) % n]);
+  std::vector<double> nearest(n, DBL_MAX);
+  while (c.centers.size() < k) {
+    size_t far = 0;
+    for (size_t i = 0; i < n; i++) {
+      nearest[i] = std::min(nearest[i], distance2(points[i], c.centers.back()));
+      if (nearest[i] > nearest[far])
+        far = i;
+    }
+    c.centers.push_back(points[far]);
+  }
+
+  c.assign.assign(n, 0);
+  for (unsigned iter = 0; iter < SIMPOINT_ITERATIONS; iter++) {
+    bool changed = (iter == 0);
+    for (size_t i = 0; i < n; i++) {
+      size_t best = 0;
+      for (size_t j = 1; j < k; j++)
+        if (distance2(points[i], c.centers[j]) < distance2(points[i], c.centers[best]))
+          best = j;
+      changed = changed || (best != c.assign[i]);
+      c.assign[i] = best;
+    }
+    if (!changed)
+      break;
+
+    std::vector<size_t> size(k, 0);
+    for (size_t j = 0; j < k; j++)
+      c.centers[j].assign(SIMPOINT_DIMS, 0.0);
+    for (size_t i = 0; i < n; i++) {
+      size[c.assign[i]]++;
+      for (unsigned d = 0; d < SIMPOINT_DIMS; d++)
+        c.centers[c.assign[i]][d] += points[i][d];
+    }
+    for (size_t j = 0; j < k; j++)
+      for (unsigned d = 0; d < SIMPOINT_DIMS; d++)
+        c.centers[j][d] = (size[j] ? c.centers[j][d] / size[j] : DBL_MAX);
+  }
+
+  c.sse = 0;
+  for (size_t i = 0; i < n; i++)
+    c.sse += distance2(points[i], c.centers[c.assign[i]]);
+  return c;
+}
+
+// Bayesian Information Criterion of a clustering (spherical Gaussians with a
+// shared variance, as in X-means and SimPoint).
+static double bic(const clustering_t& c, size_t n)
+{
+  size_t k = c.centers.size();
+  double dims = SIMPOINT_DIMS;
+  double variance = ((n > k) ? c.sse / (dims * (n - k)) : 0.0);
+  variance = std::max(variance, 1e-12);
+
+  std::vector<size_t> size(k, 0);
+  for (size_t i = 0; i < n; i++)
+    size[c.assign[i]]++;
+
+  double loglik = 0;
+  for (size_t j = 0; j < k; j++) {
+    double rn = size[j];
+    if (rn == 0)
+      continue;
+    loglik += rn * std::log(rn) - rn * std::log((double)n)
+              - rn * dims / 2 * std::log(2 * M_PI * variance)
+              - (rn - 1) * dims / 2;
+  }
+  double params = (k - 1) + dims * k + 1;
+  return loglik - params / 2 * std::log((double)n);
+}
+
+std::vector<simpoint_t> pick_simpoints(const std::vector<bbv_t>& intervals, size_t max_k)
+{
+  std::vector<simpoint_t> simpoints;
+  size_t n = intervals.size();
+  if (!n)
+    return simpoints;
+
+  // Project the normalized basic block vectors.
+  std::vector<point_t> points(n, point_t(SIMPOINT_DIMS, 0.0));
+  for (size_t i = 0; i < n; i++) {
+    double total = 0;
+    for (size_t b = 0; b < intervals[i].size(); b++)
+      total += intervals[i][b].second;
+    for (size_t b = 0; b < intervals[i].size(); b++)
+      for (unsigned d = 0; d < SIMPOINT_DIMS; d++)
+        points[i][d] += intervals[i][b].second / total * projection(intervals[i][b].first, d);
+  }
+
+  // Best of several k-means runs for each k.
+  max_k = std::max((size_t)1, std::min(max_k, n));
+  std::vector<clustering_t> best(max_k);
+  std::vector<double> score(max_k);
+  for (size_t k = 1; k <= max_k; k++) {
+    for (unsigned s = 0; s < SIMPOINT_SEEDS; s++) {
+      clustering_t c = kmeans(points, k, k * SIMPOINT_SEEDS + s);
+      if ((s == 0) || (c.sse < best[k-1].sse))
+        best[k-1] = c;
+    }
+    score[k-1] = bic(best[k-1], n);
+  }
+
+  double lo = *std::min_element(score.begin(), score.end());
+  double hi = *std::max_element(score.begin(), score.end());
+  size_t k = 1;
+  while (score[k-1] < lo + SIMPOINT_BIC_THRESHOLD * (hi - lo))
+    k++;
+  const clustering_t& c = best[k-1];
+
+  // Each cluster's simulation point is the interval closest to its centroid.
+  for (size_t j = 0; j < k; j++) {
+    size_t members = 0, closest = n;
+    for (size_t i = 0; i < n; i++) {
+      if (c.assign[i] == j) {
+        members++;
+        if ((closest == n) || (distance2(points[i], c.centers[j]) < distance2(points[closest], c.centers[j])))
+          closest = i;
+      }
+    }
+    if (members) {
+      simpoint_t sp = {closest, simpoints.size(), (double)members / n};
+      simpoints.push_back(sp);
+    }
+  }
+
+  std::sort(simpoints.begin(), simpoints.end(),
+            [](const simpoint_t& a, const simpoint_t& b) { return a.interval < b.interval; });
+  return simpoints;
+}
@@ -0,0 +1,25 @@
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+#include <cstddef>
+#include <vector>
+#include "bbtracker.h"
+
+// A simulation point: a representative interval of the program, and the
+// fraction of all intervals (its cluster) that it stands for.
+struct simpoint_t {
+  size_t interval;
+  size_t cluster;
+  double weight;
+};
+
+// Picks simulation points from the basic block vectors of all intervals,
+// like the SimPoint tool: the (normalized) vectors are randomly projected
+// to SIMPOINT_DIMS dimensions and clustered with k-means for k = 1..max_k.
+// The smallest k whose BIC score is within 90% of the best score's range
+// is chosen. Each cluster's point is the interval closest to its centroid.
+// The result is sorted by interval.
+#define SIMPOINT_DIMS 15
+std::vector<simpoint_t> pick_simpoints(const std::vector<bbv_t>& intervals, size_t max_k);
+
+#endif
@@ -51,9 +51,9 @@ enum {
 };
 
 /*----------------------------------------------------------------------------
-| Software floating-point rounding mode.
+| Software floating-point rounding mode (per host thread).
 *----------------------------------------------------------------------------*/
-extern int_fast8_t softfloat_roundingMode;
+extern __thread int_fast8_t softfloat_roundingMode;
 enum {
     softfloat_round_nearest_even   = 0,
     softfloat_round_minMag         = 1,
@@ -63,9 +63,9 @@ enum {
 };
 
 /*----------------------------------------------------------------------------
-| Software floating-point exception flags.
+| Software floating-point exception flags (per host thread).
 *----------------------------------------------------------------------------*/
-extern int_fast8_t softfloat_exceptionFlags;
+extern __thread int_fast8_t softfloat_exceptionFlags;
 enum {
     softfloat_flag_inexact   =  1,
     softfloat_flag_underflow =  2,
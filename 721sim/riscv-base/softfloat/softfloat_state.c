@@ -9,11 +9,12 @@
 
 /*----------------------------------------------------------------------------
 | Floating-point rounding mode, extended double-precision rounding precision,
-| and exception flags.
+| and exception flags.  The rounding mode and exception flags are per host
+| thread, since the ISA and timing simulators may run on different threads.
 *----------------------------------------------------------------------------*/
-int_fast8_t softfloat_roundingMode = softfloat_round_nearest_even;
+__thread int_fast8_t softfloat_roundingMode = softfloat_round_nearest_even;
 int_fast8_t softfloat_detectTininess = init_detectTininess;
-int_fast8_t softfloat_exceptionFlags = 0;
+__thread int_fast8_t softfloat_exceptionFlags = 0;
 
 int_fast8_t floatx80_roundingPrecision = 80;
 
@@ -78,30 +78,35 @@ CacheClass::CacheClass(int sets, int assoc, int _lineSize,
 
   assert(stats);
 
-#if 0
-  stats->register_counter((identifier+"_load_count").c_str()        ,identifier.c_str());
-  stats->register_counter((identifier+"_store_count").c_str()       ,identifier.c_str());
-  stats->register_counter((identifier+"_load_hit_count").c_str()    ,identifier.c_str());
-  stats->register_counter((identifier+"_store_hit_count").c_str()   ,identifier.c_str());
-  stats->register_counter((identifier+"_load_miss_count").c_str()   ,identifier.c_str());
-  stats->register_counter((identifier+"_store_miss_count").c_str()  ,identifier.c_str());
-  stats->register_counter((identifier+"_read_access_count").c_str() ,identifier.c_str());
-  stats->register_counter((identifier+"_write_access_count").c_str(),identifier.c_str());
-
-  if(verbose_phase_counters){
-    stats->register_phase_counter((identifier+"_load_count").c_str()        ,identifier.c_str());
-    stats->register_phase_counter((identifier+"_store_count").c_str()       ,identifier.c_str());
-    stats->register_phase_counter((identifier+"_load_hit_count").c_str()    ,identifier.c_str());
-    stats->register_phase_counter((identifier+"_store_hit_count").c_str()   ,identifier.c_str());
-    stats->register_phase_counter((identifier+"_load_miss_count").c_str()   ,identifier.c_str());
-    stats->register_phase_counter((identifier+"_store_miss_count").c_str()  ,identifier.c_str());
-    stats->register_phase_counter((identifier+"_read_access_count").c_str() ,identifier.c_str());
-    stats->register_phase_counter((identifier+"_write_access_count").c_str(),identifier.c_str());
-  }
-#endif
+  ctr_load         = register_counter("_load_count");
+  ctr_store        = register_counter("_store_count");
+  ctr_load_hit     = register_counter("_load_hit_count");
+  ctr_store_hit    = register_counter("_store_hit_count");
+  ctr_load_miss    = register_counter("_load_miss_count");
+  ctr_store_miss   = register_counter("_store_miss_count");
+  ctr_read_access  = register_counter("_read_access_count");
+  ctr_write_access = register_counter("_write_access_count");
+  ctr_mhsr_full    = register_counter("_mhsr_full_count");
+  ctr_writeback    = register_counter("_writeback_count");
+
+  accessLatency = new HistogramClass(histLen);
 
 }
 
+counter_id_t CacheClass::register_counter(const char* suffix)
+/*------------------------------------------------------------------------*\
+ | Register <identifier><suffix> with the stats object and return its
+ |  handle, so that Access() never has to look counters up by name.
+\*------------------------------------------------------------------------*/
+{
+  std::string name = identifier + suffix;
+
+  if (verbose_phase_counters)
+    return(stats->register_phase_counter(name.c_str(), identifier.c_str()));
+  else
+    return(stats->register_counter(name.c_str(), identifier.c_str()));
+}
+
 void CacheClass::flush()
 {
 	array.flush();
@@ -114,6 +119,7 @@ CacheClass::~CacheClass()
 {
 	delete [] mhsr;
 	delete [] missPortAvail;
+	delete accessLatency;
 
 }
 
@@ -166,11 +172,7 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 		return(curCycle);
 	}
 
-  if(isStore){
-    inc_counter_str((identifier+"_store_count").c_str());
-  } else {
-    inc_counter_str((identifier+"_load_count").c_str());
-  }
+  stats->update_counter(isStore ? ctr_store : ctr_load);
   // Line has been allocated in cache.
 	if (hit) {
 
@@ -209,22 +211,18 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 			//lineInArray = curCycle + hitLatency;
 			lineInArray = curCycle;
       if(isStore){
-        inc_counter_str((identifier+"_store_hit_count").c_str());
-        inc_counter_str((identifier+"_write_access_count").c_str());
+        stats->update_counter(ctr_store_hit);
+        stats->update_counter(ctr_write_access);
       } else {
-        inc_counter_str((identifier+"_load_hit_count").c_str());
-        inc_counter_str((identifier+"_read_access_count").c_str());
+        stats->update_counter(ctr_load_hit);
+        stats->update_counter(ctr_read_access);
       }
 		}
 	}
   // Line has not been allocated in cache.
 	else {
 
-    if(isStore){
-      inc_counter_str((identifier+"_store_miss_count").c_str());
-    } else {
-      inc_counter_str((identifier+"_load_miss_count").c_str());
-    }
+    stats->update_counter(isStore ? ctr_store_miss : ctr_load_miss);
 
 		// Allocate MHSR to handle cache miss.
     // Return error value if no free MHSR
@@ -232,6 +230,7 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
     // retry later.
 		newMHSR = FindFreeMHSR(curCycle);
 		if (newMHSR == -1) {
+		   stats->update_counter(ctr_mhsr_full);
 		   if (isHit != NULL)
 		      (*isHit) = false;
 
@@ -283,7 +282,8 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 
 			// See if line is dirty.  Line must be written back, if dirty.
 			if (line->dirty) {
-        inc_counter_str((identifier+"_read_access_count").c_str());
+        stats->update_counter(ctr_read_access);
+        stats->update_counter(ctr_writeback);
         if(nextLevel == NULL){
 				  lineInArray = lineInArray + missLatency;
         } else {
@@ -332,18 +332,56 @@ cycle_t CacheClass::Access(unsigned int Tid /* ER 11/16/02 */,
 		mhsr[newMHSR].resolved = lineInArray;
 		mhsr[newMHSR].busy = true;
 		mhsr[newMHSR].lineAddress = lineAddr;
-    inc_counter_str((identifier+"_write_access_count").c_str());
+    stats->update_counter(ctr_write_access);
 	}
 
 	if (isHit!=NULL) {
 		(*isHit) = (lineInArray == curCycle);
 	}
 
+	accessLatency->Increment((int)(lineInArray + hitLatency - curCycle));
+
   //LOG(proc->lsu_log,proc->cycle,uint64_t(0),uint64_t(0),"Executed %s which %s resolve cycle %" PRIcycle "",isStore?"store":"load",isHit?"hit":"miss",(lineInArray+hitLatency));
 
 	return(lineInArray + hitLatency);
 }
 
+void CacheClass::Warm(unsigned int Tid, reg_t addr, bool isStore)
+{
+	bool hit;
+	reg_t lineAddr;
+	reg_t oldAddr;
+	CacheLineClass* line;
+	CacheLineClass* newLine;
+
+	assert((Tid < 4) && (lineSize >= 2));
+	lineAddr = ((addr >> lineSize) | (Tid << 30));
+
+	// A hit updates the LRU state.
+	line = array.lookup(lineAddr, NULL, &hit, &oldAddr, false);
+	if (hit) {
+		if (isStore)
+			line->dirty = true;
+		return;
+	}
+
+	newLine = new CacheLineClass;
+	newLine->mhsr = -1;
+	newLine->mhsrValid = false;
+	newLine->dirty = isStore;
+	line = array.lookup(lineAddr, newLine, &hit, &oldAddr, true);
+
+	if (nextLevel != NULL) {
+		// Same approximation as Access(): the writeback goes to addr.
+		if ((line != NULL) && line->dirty)
+			nextLevel->Warm(Tid, addr, true);
+		nextLevel->Warm(Tid, addr, false);
+	}
+
+	if (line)
+		delete line;
+}
+
 void CacheClass::set_nextLevel(CacheClass* nLevel){
 	nextLevel = nLevel;
 }
@@ -378,6 +416,24 @@ int CacheClass::FindFreeMHSR(cycle_t curCycle)
 	return(-1);
 }
 
+cycle_t CacheClass::NextFreeMHSR(cycle_t curCycle)
+{
+	int i;
+	cycle_t soonest;
+
+	// Mirrors FindFreeMHSR(): an MHSR is reclaimed in the first cycle
+	//  after it resolves.
+	soonest = (cycle_t)-1;
+	for (i=0; i<numMHSR; i++) {
+		if (!mhsr[i].busy || ((cycle_t)mhsr[i].resolved < curCycle))
+			return(curCycle);
+		if (((cycle_t)mhsr[i].resolved + 1) < soonest)
+			soonest = (cycle_t)mhsr[i].resolved + 1;
+	}
+
+	return(soonest);
+}
+
 int CacheClass::FindNextPort(cycle_t curCycle, cycle_t* portAvail)
 {
 	int i;
@@ -425,9 +481,45 @@ bool CacheClass::Probe(unsigned int Tid, //RBRC
 }
 
 
+void CacheClass::dump_summary_header(FILE* fp) {
+	fprintf(fp, "CACHE MEASUREMENTS---------------------------------\n");
+	fprintf(fp, "Level         loads    ld_miss    ld_mr     stores    st_miss    st_mr  mhsr_full writebacks  avg_lat\n");
+}
+
+void CacheClass::dump_summary(FILE* fp) {
+	uint64_t loads   = stats->get_counter(ctr_load);
+	uint64_t stores  = stats->get_counter(ctr_store);
+	uint64_t ld_miss = stats->get_counter(ctr_load_miss);
+	uint64_t st_miss = stats->get_counter(ctr_store_miss);
+	uint64_t mhsr_full = stats->get_counter(ctr_mhsr_full);
+	// Accesses rejected for lack of an MHSR do not sample the latency histogram.
+	uint64_t serviced = loads + stores - mhsr_full;
+
+	fprintf(fp, "%-8s %10lu %10lu %7.2f%% %10lu %10lu %7.2f%% %10lu %10lu %8.2f\n",
+	        identifier.c_str(),
+	        loads, ld_miss, (loads ? 100.0*(double)ld_miss/(double)loads : 0.0),
+	        stores, st_miss, (stores ? 100.0*(double)st_miss/(double)stores : 0.0),
+	        mhsr_full,
+	        stats->get_counter(ctr_writeback),
+	        (serviced ? (double)accessLatency->Sum()/(double)serviced : 0.0));
+}
+
 // ER 06/19/01
 void CacheClass::set_lat(unsigned int hit_lat, unsigned int miss_lat) {
 	hitLatency = hit_lat;
 	missLatency = miss_lat;
 }
 
+
+void CacheClass::snapshot(snapshot_t& s) {
+	array.snapshot(s);
+	s.check(numMHSR, "MHSRs");
+	s.io(mhsr, numMHSR);
+	s.check(numMissSrvPorts, "miss service ports");
+	s.io(missPortAvail, numMissSrvPorts);
+	measurements(s);
+}
+
+void CacheClass::measurements(snapshot_t& s) {
+	accessLatency->snapshot(s);
+}
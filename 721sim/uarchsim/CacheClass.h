@@ -27,6 +27,7 @@
 #include "decode.h"
 #include "cache.h"
 #include "histogram.h"
+#include "stats.h"
 #include <string.h>
 
 /*--------------------------------------------------------------------------*\
@@ -110,8 +111,38 @@ public:
 	\*------------------------------------------------------------------------*/
 
 	bool Probe(unsigned int Tid,cycle_t curCycle, reg_t addr1, unsigned int length);
+
+	void Warm(unsigned int Tid, reg_t addr, bool isStore);
+	/*------------------------------------------------------------------------*\
+	 | Functional warming: update the cache's contents and LRU state (and the
+	 |  next level's, on a miss) as an access would, with no timing and no
+	 |  stats.  Misses are allocated as if already resolved.
+	\*------------------------------------------------------------------------*/
+
+	cycle_t NextFreeMHSR(cycle_t curCycle);
+	/*------------------------------------------------------------------------*\
+	 | Returns the earliest cycle, at or after curCycle, in which an access
+	 |  that misses can allocate an MHSR.
+	\*------------------------------------------------------------------------*/
 	HistogramClass* accessLatency;
 	void set_nextLevel(CacheClass* nLevel);
+
+	static void dump_summary_header(FILE* fp);
+	void dump_summary(FILE* fp);
+	/*------------------------------------------------------------------------*\
+	 | Print one row of the per-level cache summary table (and its header).
+	\*------------------------------------------------------------------------*/
+
+	void snapshot(snapshot_t& s);
+	/*------------------------------------------------------------------------*\
+	 | Save or restore the tags, LRU state, line states, MHSRs, and miss
+	 |  ports (see snapshot.h).  Stats counters are saved by stats_t.
+	\*------------------------------------------------------------------------*/
+
+	void measurements(snapshot_t& s);
+	/*------------------------------------------------------------------------*\
+	 | Save or restore the measurements only (the access latency histogram).
+	\*------------------------------------------------------------------------*/
 private:
 
   pipeline_t* proc;
@@ -135,6 +166,21 @@ private:
 
   stats_t* stats;
 
+  /* Counter handles, registered once at construction.  Named
+   *  <identifier>_<counter> in stats.log.                                 */
+  counter_id_t ctr_load;
+  counter_id_t ctr_store;
+  counter_id_t ctr_load_hit;
+  counter_id_t ctr_store_hit;
+  counter_id_t ctr_load_miss;
+  counter_id_t ctr_store_miss;
+  counter_id_t ctr_read_access;
+  counter_id_t ctr_write_access;
+  counter_id_t ctr_mhsr_full;
+  counter_id_t ctr_writeback;
+
+  counter_id_t register_counter(const char* suffix);
+
 };
 
 #endif //DCACHE_H
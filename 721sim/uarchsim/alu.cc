@@ -39,8 +39,8 @@ void pipeline_t::agen(unsigned int index) {
 
 	//// Adjust address of the lower half of DLW and DSW.
 	//if ((inst.opcode() == DLW) || (inst.opcode() == DSW)) {
-	//	assert(PAY.buf[index].split);
-	//	if (!PAY.buf[index].upper) {
+	//	assert(PAY.cold(index).split);
+	//	if (!PAY.cold(index).upper) {
 	//		PAY.buf[index].addr += 4;
 	//	}
 	//}
@@ -7,6 +7,7 @@
 
 #include "fetchunit_types.h"
 #include "bq.h"
+#include "snapshot.h"
 
 bq_t::bq_t(uint64_t size) {
    this->size = ((size > 0) ? size : 1);
@@ -107,3 +108,12 @@ uint64_t bq_t::flush() {
    // Return the index of the head entry.
    return(head);
 }
+
+void bq_t::snapshot(snapshot_t &s) {
+   s.check(size, "branch queue size");
+   s.io(bq, size);
+   s.io(head);
+   s.io(tail);
+   s.io(head_phase);
+   s.io(tail_phase);
+}
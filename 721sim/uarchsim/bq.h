@@ -26,6 +26,8 @@ public:
 };
 
 
+class snapshot_t;
+
 class bq_t {
 private:
 	uint64_t size;
@@ -46,5 +48,8 @@ public:
 	void rollback(uint64_t pred_tag, bool pred_tag_phase, bool do_checks);
 	void mark(uint64_t &pred_tag, bool &pred_tag_phase);
 	uint64_t flush();
+
+	// Save or restore the branch queue.
+	void snapshot(snapshot_t &s);
 };
 
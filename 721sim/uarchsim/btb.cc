@@ -8,6 +8,7 @@
 
 #include "fetchunit_types.h"
 #include "btb.h"
+#include "snapshot.h"
 
 
 btb_t::btb_t(uint64_t num_entries, uint64_t banks, uint64_t assoc, uint64_t cond_branch_per_cycle) {
@@ -342,6 +343,31 @@ void btb_t::update_lru(uint64_t btb_bank, uint64_t set, uint64_t way) {
 }
 
 
+//
+// pc: The pc of a branch that was executed during functional warming.
+//
+// Role of this function: Add the branch to the BTB, or touch its entry if it is already there, as a misfetch followed by hits would.
+// The bank and set depend only on the branch's pc, not on the start pc of its fetch bundle.
+//
+void btb_t::warm(uint64_t pc, insn_t insn) {
+   uint64_t btb_bank;
+   uint64_t btb_pc;
+   uint64_t set;
+   uint64_t way;
+   uint64_t target;
+   btb_branch_type_e branch_type;
+
+   branch_type = btb_t::decode(insn, pc, target);
+   convert(pc, 0, btb_bank, btb_pc);
+   if (search(btb_bank, btb_pc, set, way) &&
+       (btb[btb_bank][set][way].branch_type == branch_type) &&
+       ((insn.opcode() == OP_JALR) || (btb[btb_bank][set][way].target == target)))
+      update_lru(btb_bank, set, way);
+   else
+      update(pc, 0, insn);
+}
+
+
 btb_branch_type_e btb_t::decode(insn_t insn, uint64_t pc, uint64_t &target) {
    btb_branch_type_e branch_type;
    switch (insn.opcode()) {
@@ -379,6 +405,15 @@ btb_branch_type_e btb_t::decode(insn_t insn, uint64_t pc, uint64_t &target) {
    return(branch_type);
 }
 
+void btb_t::snapshot(snapshot_t &s) {
+   s.check(banks, "BTB banks");
+   s.check(sets, "BTB sets");
+   s.check(assoc, "BTB associativity");
+   for (uint64_t b = 0; b < banks; b++)
+      for (uint64_t set = 0; set < sets; set++)
+         s.io(btb[b][set], assoc);
+}
+
 
 
 
@@ -14,6 +14,8 @@ struct {
 
 
 
+class snapshot_t;
+
 class btb_t {
 private:
 	// The BTB has three dimensions: number of banks, number of sets per bank, and associativity (number of ways per set).
@@ -44,5 +46,9 @@ public:
         void lookup(uint64_t pc, uint64_t cb_predictions, uint64_t ib_predicted_target, uint64_t ras_predicted_target, fetch_bundle_t bundle[], spec_update_t *update);
 	void update(uint64_t pc, uint64_t pos, insn_t insn);
 	void invalidate(uint64_t pc, uint64_t pos);
+	void warm(uint64_t pc, insn_t insn);
 	static btb_branch_type_e decode(insn_t insn, uint64_t pc, uint64_t &target);
+
+	// Save or restore all BTB entries.
+	void snapshot(snapshot_t &s);
 };
@@ -3,8 +3,13 @@
 #pragma interface
 #include <cstdio>
 #include <cassert>
+#include <cstdlib>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 #include "common.h"
 #include "decode.h"
+#include "snapshot.h"
 
 
 #define	INVALID		-1
@@ -13,21 +18,32 @@
 ///////////////////////
 // STANDARD CACHE
 ///////////////////////
+//
+// The tag store is one contiguous, cache-line-aligned array per cache,
+// laid out set-major: the 'assoc' tags of set i occupy
+// tags[i*assoc .. i*assoc+assoc-1].  LRU state and contents pointers live
+// in parallel arrays with the same layout.
+//
+// Tag search compares several ways at once with SSE2 (two 64-bit tags
+// per compare) or AVX2 (four), when the compiler targets them, and
+// falls back to a scalar loop otherwise.  The lowest matching way wins,
+// exactly as in a way-by-way scan.
+//
+// LRU state is an 8-bit age per way: 0 is most-recently used,
+// assoc-1 is least-recently used.  The ages of a set are always a
+// permutation of 0..assoc-1.
+//
 template<class T>
 class cache {
 private:
-	// The cache is a 2-D array of entries, each entry
-	// is a tag + lru + pointer to object of type T.
+	reg_t*		tags;		// size*assoc tags
+	unsigned char*	age;		// size*assoc LRU ages
+	T**		contents;	// size*assoc contents pointers
 
-	typedef
-	struct {
-		reg_t tag;
-		unsigned int lru;
-		T* contents;
-	} entry;
-
-	entry**	C;
+	// Index of the lowest way in 'set' whose tag equals 'id', or 'assoc' if none.
+	inline unsigned int match(const reg_t* set, reg_t id);
 
+	void reset();
 
 public:
 	// size = number of entries deep
@@ -40,32 +56,38 @@ public:
 
 	// constructor
 	cache(unsigned int size, unsigned int assoc) {
-		unsigned int i,j;
+		void* p;
 
 		// First ensure that 'size' is a power of 2.
 		assert( IsPow2(size) );
-
-		C = new entry *[size];
-		for (i = 0; i < size; i++) {
-			C[i] = new entry[assoc];
-			for (j = 0; j < assoc; j++) {
-				C[i][j].tag = INVALID;
-				C[i][j].lru = j;
-				C[i][j].contents = (T*)NULL;
-			}
-		}
+		// Ages are stored in 8 bits.
+		assert((assoc > 0) && (assoc <= 256));
 
 		this->size = size;
 		this->assoc = assoc;
 		this->num_misses = 0;
+
+		p = NULL;
+		if (posix_memalign(&p, 64, (size_t)size * assoc * sizeof(reg_t)))
+			assert(0);
+		tags = (reg_t*)p;
+		p = NULL;
+		if (posix_memalign(&p, 64, (size_t)size * assoc * sizeof(unsigned char)))
+			assert(0);
+		age = (unsigned char*)p;
+		p = NULL;
+		if (posix_memalign(&p, 64, (size_t)size * assoc * sizeof(T*)))
+			assert(0);
+		contents = (T**)p;
+
+		reset();
 	}
 
 	// destructor
 	~cache() {
-		//unsigned int i;
-		//for (i = 0; i < size; i++)
-		//   delete C[i];
-		//delete C;
+		free(tags);
+		free(age);
+		free(contents);
 	}
 
 	//
@@ -74,15 +96,7 @@ public:
 	// Added by Quinn Jacobson, October 7, 1998.
 	//
 	void flush() {
-		unsigned int i,j;
-
-		for (i = 0; i < size; i++) {
-			for (j = 0; j < assoc; j++) {
-				C[i][j].tag = INVALID;
-				C[i][j].lru = j;
-				C[i][j].contents = (T*)NULL;
-			}
-		}
+		reset();
 	}
 
 
@@ -100,8 +114,80 @@ public:
 	          bool replace,
 	          bool use_raw_index = false,
 	          unsigned int raw_index = 0);
+
+	void snapshot(snapshot_t& s);
 };
 
+// Save or restore the tags, LRU ages, and contents (by value).
+template<class T>
+void cache<T>::snapshot(snapshot_t& s) {
+	unsigned int i;
+	bool present;
+
+	s.check(size, "cache sets");
+	s.check(assoc, "cache associativity");
+	s.io(tags, (size_t)size * assoc);
+	s.io(age, (size_t)size * assoc);
+	s.io(num_misses);
+	for (i = 0; i < size * assoc; i++) {
+		present = (contents[i] != NULL);
+		s.io(present);
+		if (!s.saving()) {
+			delete contents[i];
+			contents[i] = (present ? new T : (T*)NULL);
+		}
+		if (present)
+			s.io(*contents[i]);
+	}
+}
+
+
+template<class T>
+void cache<T>::reset() {
+	unsigned int i,j;
+
+	for (i = 0; i < size; i++) {
+		for (j = 0; j < assoc; j++) {
+			tags[i*assoc + j] = (reg_t)INVALID;
+			age[i*assoc + j] = (unsigned char)j;
+			contents[i*assoc + j] = (T*)NULL;
+		}
+	}
+}
+
+template<class T>
+inline unsigned int cache<T>::match(const reg_t* set, reg_t id) {
+	unsigned int i = 0;
+	unsigned int m;
+
+#if defined(__AVX2__)
+	const __m256i key4 = _mm256_set1_epi64x((long long)id);
+	for (; i + 4 <= assoc; i += 4) {
+		m = (unsigned int)_mm256_movemask_pd(_mm256_castsi256_pd(
+		       _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(set + i)), key4)));
+		if (m)
+			return(i + __builtin_ctz(m));
+	}
+#endif
+#if defined(__SSE2__)
+	// SSE2 has no 64-bit compare: compare 32-bit halves, then AND each
+	// half's result with its neighbour's.
+	const __m128i key2 = _mm_set1_epi64x((long long)id);
+	__m128i eq;
+	for (; i + 2 <= assoc; i += 2) {
+		eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(set + i)), key2);
+		eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2,3,0,1)));
+		m = (unsigned int)_mm_movemask_pd(_mm_castsi128_pd(eq));
+		if (m)
+			return(i + __builtin_ctz(m));
+	}
+#endif
+	for (; i < assoc; i++) {
+		if (set[i] == id)
+			return(i);
+	}
+	return(assoc);
+}
 
 template<class T>
 T* cache<T>::lookup(reg_t id, T* contents,
@@ -109,78 +195,70 @@ T* cache<T>::lookup(reg_t id, T* contents,
                     bool replace,
                     bool use_raw_index, unsigned int raw_index) {
 	unsigned int index;
-	entry* set;
+	unsigned int base;
+	reg_t* set_tags;
+	unsigned char* set_age;
+	T** set_contents;
 	unsigned int i;
-	bool found;
 	unsigned int hit_way;
+	unsigned char hit_age;
+	unsigned char lru_age;
 	int replace_way;
 	T* old_contents;
 
 	index = MOD((use_raw_index ? raw_index : id), size);
-	set = C[index];
+	base = index * assoc;
+	set_tags = &tags[base];
+	set_age = &age[base];
+	set_contents = &this->contents[base];
 
-	i = 0;
-	found = false;
-	while (i < assoc && !found) {
-		if (set[i].tag == id) {
-			found = true;
-		}
-		else {
-			i += 1;
-		}
-	}
-
-	if (found) {
-		hit_way = i;
+	hit_way = match(set_tags, id);
 
+	if (hit_way < assoc) {
 		// Update LRU state.
+		hit_age = set_age[hit_way];
 		for (i = 0; i < assoc; i++) {
-			if (set[i].lru < set[hit_way].lru) {
-				set[i].lru += 1;
-			}
+			set_age[i] += (set_age[i] < hit_age);
 		}
-		set[hit_way].lru = 0;
+		set_age[hit_way] = 0;
 
 		// Set outputs of function.
 		*hit = true;
-		*old_id = set[hit_way].tag;
-		old_contents = set[hit_way].contents;
+		*old_id = set_tags[hit_way];
+		old_contents = set_contents[hit_way];
 	}
 	else {
 		// record the miss
 		num_misses += 1;
 
-		// Find replacement entry, and update LRU state.
+		// Find replacement entry (the least-recently used way).
+		lru_age = (unsigned char)(assoc-1);
 		replace_way = -1;
-		if (replace) {
-			for (i = 0; i < assoc; i++) {
-				if (set[i].lru == (assoc-1)) {	// least-recently used
-					replace_way = (int)i;
-					set[i].lru = 0;
-				}
-				else {
-					set[i].lru += 1;
-				}
+		for (i = 0; i < assoc; i++) {
+			if (set_age[i] == lru_age) {
+				replace_way = (int)i;
+				break;
 			}
 		}
-		else {
+		assert(replace_way != -1);
+
+		// Update LRU state.
+		if (replace) {
 			for (i = 0; i < assoc; i++) {
-				if (set[i].lru == (assoc-1)) {	// least-recently used
-					replace_way = (int)i;
-				}
+				set_age[i] += 1;
 			}
+			set_age[replace_way] = 0;
 		}
-		assert(replace_way != -1);
 
 		// Set outputs of function.
 		*hit = false;
-		*old_id = set[replace_way].tag;
-		old_contents = set[replace_way].contents;
+		*old_id = set_tags[replace_way];
+		old_contents = set_contents[replace_way];
 
 		// Perform the actual replacement.
 		if (replace) {
-			set[replace_way].tag = id;
-			set[replace_way].contents = contents;
+			set_tags[replace_way] = id;
+			set_contents[replace_way] = contents;
 		}
 	}
 
@@ -66,13 +66,18 @@ void pipeline_t::checker() {
 	 unsigned int head;	// Index of the head instruction in PAY.
 	 db_t *actual;		// Pointer to corresponding instruction in the functional simulator.
 
+	 // Without an ISA simulator (--no-checker), there is nothing to
+	 // check against.
+	 if (!pipe)
+	    return;
+
 	 // Get the index of the head instruction in PAY.
 	 head = PAY.head;
 
    // Get pointer to the corresponding instruction in the functional simulator.
 	 // This enables checking results of the pipeline simulator.
 	 assert(PAY.buf[head].good_instruction && (PAY.buf[head].db_index != DEBUG_INDEX_INVALID));
-	 if (PAY.buf[head].split && PAY.buf[head].upper)
+	 if (PAY.cold(head).split && PAY.cold(head).upper)
 	    actual = pipe->peek(PAY.buf[head].db_index);
 	 else
 	    actual = pipe->pop(PAY.buf[head].db_index);
@@ -91,7 +96,7 @@ void pipeline_t::checker() {
    }
    // If not an architectural exception
    else{
-	   if (PAY.buf[head].split) {
+	   if (PAY.cold(head).split) {
 	      switch (PAY.buf[head].inst.opcode()) {
 
 	         default:
@@ -1,30 +1,32 @@
 #include <cassert>
 #include "debug.h"
 #include "sim.h"
+#include "htif.h"
 //#include "processor.h"
 #include "pipeline.h"
+#include "snapshot.h"
 extern bool logging_on;
 
-// Checks to see if index 'e' lies between 'head' and 'tail'.
+// Checks to see if index 'e' lies within the timing simulator's window:
+// between 'head' and the window's end, and already filled by the ISA
+// simulator (waiting for it if it has not got there yet).
 bool debug_buffer_t::is_active(unsigned int e) {
-   if (length > 0) {
-      if (head <= tail)
-         return((e >= head) && (e <= tail));
-      else
-         return((e >= head) || (e <= tail));
-   }
-   else {
+   uint64_t n;
+
+   n = consumed + MOD((e + DEBUG_SIZE - head), DEBUG_SIZE);
+   if (n >= window_end())
       return(false);
-   }
+
+   wait_entry(n);
+   return(n < produced.load(std::memory_order_acquire));
 }
 
 
-debug_buffer_t::debug_buffer_t(unsigned int window_size) {
+debug_buffer_t::debug_buffer_t(unsigned int window_size, bool threaded) {
    // Set the full size and active size of the debug buffer.
    // Both had better be a power of two.
-   // DEBUG_SIZE = 4*window_size;
-   // ACTIVE_SIZE = 2*window_size;
-   DEBUG_SIZE   = window_size; 
+   // The ISA simulator thread may run up to another window ahead.
+   DEBUG_SIZE   = (threaded ? 2*window_size : window_size);
    ACTIVE_SIZE  = window_size;
    assert(IsPow2(DEBUG_SIZE) && IsPow2(ACTIVE_SIZE));
 
@@ -40,13 +42,23 @@ debug_buffer_t::debug_buffer_t(unsigned int window_size) {
    // Initialize debug buffer.
    head = 0;
    tail = (DEBUG_SIZE - 1);
-   length = 0;
+   consumed = 0;
+   started = 0;
 
    pc_ptr = 0;
    inst_sequence = 0;
+
+   this->threaded = threaded;
+   produced = 0;
+   released = 0;
+   isa_done = false;
+   stop_req = false;
+   producer_waiting = false;
+   consumer_waiting = false;
 }
 
 debug_buffer_t::~debug_buffer_t() {
+   stop_thread();
 }
 
 void debug_buffer_t::run_ahead(){
@@ -56,12 +68,128 @@ void debug_buffer_t::run_ahead(){
   // Set to checker mode so that instructions are pushed to 
   // debug buffer
   isa_sim->set_procs_checker(true);
-  while(hungry()){
+  while((started < ACTIVE_SIZE) && isa_sim->running()){
     ifprintf(logging_on,stderr, "Functional simulator hungry\n");
-    isa_sim->step();  // Step 1 cycle, which is 1 instruction for isa_sim.
+    produce();
   }
 }
 
+void debug_buffer_t::produce() {
+   isa_sim->step();  // Step 1 cycle, which is 1 instruction for isa_sim.
+
+   // Publish the entry (or entries) started by the step.
+   produced.store(started);
+   if (consumer_waiting.load()) {
+      std::lock_guard<std::mutex> l(handoff_lock);
+      consumer_cv.notify_one();
+   }
+}
+
+bool debug_buffer_t::wait_room() {
+   if (room())
+      return(true);
+
+   std::unique_lock<std::mutex> l(handoff_lock);
+   producer_waiting = true;
+   producer_cv.wait(l, [this]{ return(room() || stop_req.load()); });
+   producer_waiting = false;
+   return(!stop_req.load());
+}
+
+void debug_buffer_t::release(uint64_t n) {
+   released.store(n);
+
+   // Wake a waiting producer only once a quarter of the ring is free,
+   // so that the two threads do not hand off on every entry.
+   if (producer_waiting.load() &&
+       ((n + DEBUG_SIZE - produced.load()) >= (DEBUG_SIZE >> 2))) {
+      std::lock_guard<std::mutex> l(handoff_lock);
+      producer_cv.notify_one();
+   }
+}
+
+void debug_buffer_t::wait_entry(uint64_t n) {
+   if (!threaded || (produced.load(std::memory_order_acquire) > n) || isa_done.load())
+      return;
+
+   std::unique_lock<std::mutex> l(handoff_lock);
+   consumer_waiting = true;
+   producer_cv.notify_one();	// Don't leave the producer parked on the low-water mark.
+   consumer_cv.wait(l, [this,n]{ return((produced.load() > n) || isa_done.load()); });
+   consumer_waiting = false;
+}
+
+void debug_buffer_t::isa_thread_main() {
+   // HTIF's host coroutine hands control back to whichever thread
+   // ticks it; make that this thread from now on.
+   isa_sim->get_htif()->set_target_thread();
+
+   while (isa_sim->running() && wait_room())
+      produce();
+
+   std::lock_guard<std::mutex> l(handoff_lock);
+   isa_done = true;
+   consumer_cv.notify_all();
+}
+
+void debug_buffer_t::start_thread() {
+   if (threaded && !isa_thread.joinable()) {
+      fprintf(stderr, "Functional simulator running ahead on its own thread\n");
+      stop_req = false;
+      isa_done = false;
+      isa_thread = std::thread(&debug_buffer_t::isa_thread_main, this);
+   }
+}
+
+void debug_buffer_t::stop_thread() {
+   if (isa_thread.joinable()) {
+      {
+         std::lock_guard<std::mutex> l(handoff_lock);
+         stop_req = true;
+         producer_cv.notify_all();
+      }
+      isa_thread.join();
+   }
+}
+
+void debug_buffer_t::snapshot(snapshot_t& s) {
+   assert(!isa_thread.joinable());
+   s.check(DEBUG_SIZE, "debug buffer size");
+   s.check(ACTIVE_SIZE, "debug buffer window");
+
+   s.io(head);
+   s.io(tail);
+   s.io(consumed);
+   s.io(started);
+   s.io(inst_sequence);
+   s.io(pc_ptr);
+
+   uint64_t n = produced.load();
+   s.io(n);
+   produced = n;
+   n = released.load();
+   s.io(n);
+   released = n;
+   bool done = isa_done.load();
+   s.io(done);
+   isa_done = done;
+
+   // Every entry, including ones not yet refilled: an entry's state is
+   // only partly overwritten when it is reused (see push_state_actual()).
+   for (unsigned int i = 0; i < DEBUG_SIZE; i++) {
+      state_t* a_state = db[i].a_state;
+      s.io(db[i]);
+      db[i].a_state = a_state;
+      s.io(*a_state);
+   }
+
+   isa_sim->snapshot(s);
+   if (!s.saving()) {
+      isa_sim->set_procs_debug(true);
+      isa_sim->set_procs_checker(true);
+   }
+}
+
 void debug_buffer_t::skip_till_pc(reg_t pc, unsigned int proc_id){
   ifprintf(logging_on,stderr, "Functional simulator skipping till PC %" PRIreg "\n",pc);
   bool old_debug = isa_sim->get_procs_debug();
@@ -73,10 +201,45 @@ void debug_buffer_t::skip_till_pc(reg_t pc, unsigned int proc_id){
   isa_sim->set_procs_debug(old_debug);
 }
 
+bool debug_buffer_t::skip(uint64_t n){
+  bool was_threaded = isa_thread.joinable();
+  stop_thread();
+
+  // Instructions the ISA simulator already ran ahead are popped, the rest
+  // are fast skipped: the buffer is empty then.
+  uint64_t ahead = std::min(n, produced.load() - consumed);
+  head = MOD((head + ahead), DEBUG_SIZE);
+  consumed += ahead;
+  released = consumed;
+  pc_ptr = head;
+
+  bool htif_return = true;
+  if (n > ahead) {
+    assert(consumed == started);
+    if (was_threaded)
+      isa_sim->get_htif()->set_target_thread();
+    isa_sim->set_procs_debug(false);
+    htif_return = isa_sim->run_fast(n - ahead);
+    isa_sim->set_procs_debug(true);
+  }
+
+  // Fill out the debug buffer again.
+  stop_req = false;
+  isa_done = false;
+  if (was_threaded) {
+    isa_thread = std::thread(&debug_buffer_t::isa_thread_main, this);
+  }
+  else {
+    while (room() && isa_sim->running())
+      produce();
+  }
+  return htif_return;
+}
+
 void debug_buffer_t::start() {
-   // Check for overflow and maintain 'length'.
-   assert(length < ACTIVE_SIZE);
-   length += 1;
+   // Check for overflow.
+   assert(room());
+   started += 1;
 
    // Initialize a new debug entry.
    tail = MOD((tail + 1), DEBUG_SIZE);
@@ -277,33 +440,39 @@ void debug_buffer_t::push_state_actual(state_t* a_state_ptr,bool checkpoint_stat
 
 // Assert that the index of the head debug buffer entry equals 'i'.
 // Then pop the head entry, returning a pointer to the contents of
-// that entry.
+// that entry.  The entry stays intact until the next pop.
 db_t* debug_buffer_t::pop(debug_index_t i) {
 
    ifprintf(logging_on,stderr, "Timing simulator popping entry %u\n",i);
    assert(i == head);
 
-   // Set the valid bit to 0 so that perfect branch prediction
-   // does not fail at PC mismatch assertion at the end of the 
-   // program.
-   db[head].a_valid = false;
-
+   // The previously popped entry is no longer referenced:
+   // its slot may be refilled.
+   release(consumed);
 
-   // Fill out the debug buffer
+   // Fill out the debug buffer, if the ISA simulator is not
+   // running ahead on its own thread.
    // Make sure the simulator is still running and is not already 
    // done with the program.
-   while(hungry() && isa_sim->running()){
-    ifprintf(logging_on,stderr, "Functional simulator hungry\n");
-     isa_sim->step();  // Step 1 cycle, which is 1 instruction for isa_sim.
+   if (!threaded) {
+      while(room() && isa_sim->running()){
+         ifprintf(logging_on,stderr, "Functional simulator hungry\n");
+         produce();
+      }
    }
 
-   // Check for underflow and maintain 'length'.
-   assert(length > 0);
-   length -= 1;
+   // Check for underflow.
+   wait_entry(consumed);
+   assert(consumed < produced.load());
+
+   // Set the valid bit to 0 so that perfect branch prediction
+   // does not fail at PC mismatch assertion at the end of the 
+   // program.
+   db[head].a_valid = false;
 
    // Pop the head entry by advancing head pointer.
    head = MOD((head + 1), DEBUG_SIZE);
-
+   consumed += 1;
 
    // Return a pointer to (what was) the head entry.
    return( &(db[i]) );
@@ -3,6 +3,10 @@
 
 #include <cstdio>
 #include <cassert>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "common.h"
 #include "decode.h"
 
@@ -88,6 +92,7 @@ typedef unsigned int	debug_index_t;
 
 class sim_t;
 class pipeline_t;
+class snapshot_t;
 
 class debug_buffer_t {
 
@@ -96,13 +101,27 @@ private:
 	// DEBUG BUFFER
 	///////////////////////////////////////////////////
 
+	// The debug buffer is a single-producer/single-consumer ring.
+	// The ISA simulator (producer) fills entries at 'tail' and the
+	// timing simulator (consumer) reads them from 'head'.
+	//
+	// The timing simulator only ever sees a window of ACTIVE_SIZE
+	// entries, exactly as if the ISA simulator were stepped inline
+	// whenever an entry is popped.  This keeps the timing simulation
+	// deterministic regardless of how far ahead the ISA simulator is.
+	//
+	// When the ISA simulator runs on its own host thread, the ring
+	// holds DEBUG_SIZE = 2*ACTIVE_SIZE entries so that it can run up
+	// to ACTIVE_SIZE entries beyond the window before it must wait.
+
 	unsigned int DEBUG_SIZE;
 	unsigned int ACTIVE_SIZE;
 
 	db_t* db;
-	debug_index_t head;
-	debug_index_t tail;
-	unsigned int  length;
+	debug_index_t head;	// Consumer: index of the oldest un-popped entry.
+	debug_index_t tail;	// Producer: index of the entry being filled.
+	uint64_t consumed;	// Consumer: number of entries popped so far.
+	uint64_t started;	// Producer: number of entries started so far.
 
   uint64_t    inst_sequence;
 
@@ -111,34 +130,79 @@ private:
 
   sim_t* isa_sim;
 
+  ///////////////////////
+  // PRODUCER/CONSUMER HANDOFF
+  ///////////////////////
+
+  bool threaded;			// ISA simulator runs on isa_thread.
+  std::thread isa_thread;
+  std::atomic<uint64_t> produced;	// Entries completely filled by the ISA simulator.
+  std::atomic<uint64_t> released;	// Entries the timing simulator no longer references.
+  std::atomic<bool> isa_done;		// ISA simulator stopped running: no more entries.
+  std::atomic<bool> stop_req;		// Ask isa_thread to exit.
+  std::atomic<bool> producer_waiting;
+  std::atomic<bool> consumer_waiting;
+  std::mutex handoff_lock;
+  std::condition_variable producer_cv;
+  std::condition_variable consumer_cv;
+
   ///////////////////////
   // PRIVATE FUNCTIONS
   ///////////////////////
 
-  // Checks to see if index 'e' lies between 'head' and 'tail'.
+  // Checks to see if index 'e' lies within the timing simulator's window.
   bool is_active(unsigned int e);
 
+  // One past the last entry in the timing simulator's window.
+  inline uint64_t window_end() {
+     return(consumed ? (consumed + ACTIVE_SIZE - 1) : ACTIVE_SIZE);
+  }
+
+  // Producer: is there a free slot for the next entry?
+  inline bool room() {
+     return(started < (released.load(std::memory_order_acquire) + DEBUG_SIZE));
+  }
+
+  void produce();			// Producer: step the ISA simulator one instruction and publish its entry.
+  bool wait_room();			// Producer: block until room() or stop is requested.
+  void release(uint64_t n);		// Consumer: entries before 'n' may be overwritten.
+  void wait_entry(uint64_t n);		// Consumer: block until entry 'n' is filled or the ISA simulator is done.
+  void isa_thread_main();
+
 public:
 	///////////////
 	// INTERFACE
 	///////////////
 
-	debug_buffer_t(unsigned int window_size);
+	debug_buffer_t(unsigned int window_size, bool threaded = false);
 	~debug_buffer_t();
 
   void set_isa_sim(sim_t* _isa_sim){ isa_sim = _isa_sim; }
+  sim_t* get_isa_sim(){ return isa_sim; }
   void run_ahead();
   void skip_till_pc(reg_t pc, unsigned int proc_id);
 
+  // Advance the ISA simulator past the next 'n' instructions, which the
+  // timing simulator fast skipped (see sim_t::run_sampled()). The timing
+  // simulator must not reference any entry: its pipeline is empty.
+  bool skip(uint64_t n);
+
+  // Move the ISA simulator onto its own host thread (if 'threaded'),
+  // and stop/join that thread.  The ISA simulator must not be touched
+  // by any other thread in between.
+  void start_thread();
+  void stop_thread();
+  bool thread_running() { return(isa_thread.joinable()); }
+
+  // Save or restore the debug buffer and the ISA simulator's run state
+  // (see sim_t::write_snapshot()). The ISA simulator thread must be stopped.
+  // Restoring sets the ISA simulator up as run_ahead() does.
+  void snapshot(snapshot_t& s);
+
 	//////////////////////////////////////////////////////////////
 	// Interface for collecting functional simulator state.
 	//////////////////////////////////////////////////////////////
 
-	inline	bool hungry() {
-    ifprintf(logging_on,stderr, "Debug buffer head: %u tail %u length %u active size %u\n",head,tail,length,ACTIVE_SIZE);
-	   return(length < ACTIVE_SIZE);
-	}
-
 	void start();
 	void push_operand_actual( unsigned int n, operand_t t, reg_t value, reg_t pc);
 	void push_address_actual( reg_t addr, operand_t t, reg_t pc, reg_t real_upper, unsigned int real_lower);
@@ -155,6 +219,7 @@ public:
 	// value equal to 'pc'.
 	// Then return the index of the head entry.
 	inline debug_index_t first(reg_t pc) {
+	   wait_entry(consumed);
 	   assert(pc == db[head].a_pc);
 	   return(head);
 	}
@@ -178,12 +243,13 @@ public:
 	// Return a pointer to the contents of an arbitrary debug buffer entry.
 	// The debug buffer entry must be in the 'active window' of the buffer.
 	inline	db_t *peek(debug_index_t i) {
-	   assert(is_active(i));
+	   bool active = is_active(i);
+	   assert(active);
 	   return( &(db[i]) );
 	}
 
 	inline	bool empty() {
-	   return(length == 0);
+	   return(!is_active(head));
 	}
 
   db_t* pop(debug_index_t i);
@@ -164,8 +164,8 @@ void pipeline_t::decode() {
 		// Select IQ.
 
 		// Default values.
-		PAY.buf[index].split = false;
-		PAY.buf[index].split_store = false;
+		PAY.cold(index).split = false;
+		PAY.cold(index).split_store = false;
 		PAY.buf[index].A_valid = false;
 		PAY.buf[index].B_valid = false;
 		PAY.buf[index].C_valid = false;
@@ -354,7 +354,7 @@ void pipeline_t::decode() {
 				    PAY.buf[index].C_valid = true;
 				    PAY.buf[index].C_log_reg = inst.rd();
             // CSR address
-				    PAY.buf[index].CSR_addr = inst.csr();
+				    PAY.cold(index).CSR_addr = inst.csr();
             break;
           case FN3_CLR_IMM:
           case FN3_RW_IMM:
@@ -367,26 +367,26 @@ void pipeline_t::decode() {
 				    PAY.buf[index].C_valid = true;
 				    PAY.buf[index].C_log_reg = inst.rd();
             // CSR address
-				    PAY.buf[index].CSR_addr = inst.csr();
+				    PAY.cold(index).CSR_addr = inst.csr();
             break;
           case FN3_SC_SB:
             if(inst.funct12() == FN12_SRET){
-				      PAY.buf[index].CSR_addr = CSR_STATUS;
+				      PAY.cold(index).CSR_addr = CSR_STATUS;
             }
             else {
   				    // Select IQ.
 	  			    PAY.buf[index].iq = SEL_IQ_NONE;
 	  			    if (inst.funct12() == FN12_SCALL)
-	  			       PAY.buf[index].trap.post(trap_syscall());
+	  			       PAY.cold(index).trap.post(trap_syscall());
 	  			    else if (inst.funct12() == FN12_SBREAK)
-	  			       PAY.buf[index].trap.post(trap_breakpoint());
+	  			       PAY.cold(index).trap.post(trap_breakpoint());
 	  			    else
-				       PAY.buf[index].trap.post(trap_illegal_instruction());
+				       PAY.cold(index).trap.post(trap_illegal_instruction());
             }
             break;
           default:
             PAY.buf[index].iq = SEL_IQ_NONE;
-            PAY.buf[index].trap.post(trap_illegal_instruction());
+            PAY.cold(index).trap.post(trap_illegal_instruction());
             break;
         }         
 				break;
@@ -444,12 +444,12 @@ void pipeline_t::decode() {
 							break;
 						default:
 							PAY.buf[index].iq = SEL_IQ_NONE;
-							PAY.buf[index].trap.post(trap_illegal_instruction());
+							PAY.cold(index).trap.post(trap_illegal_instruction());
 							break;
 					}
 				} else {
 					PAY.buf[index].iq = SEL_IQ_NONE;
-					PAY.buf[index].trap.post(trap_illegal_instruction());
+					PAY.cold(index).trap.post(trap_illegal_instruction());
 				}
         break;
 
@@ -505,8 +505,8 @@ void pipeline_t::decode() {
 			case OP_AMO:
 				PAY.buf[index].size = inst.ldst_size();      // Load size is encoded in funct3/width[1:0] field or inst[13:12]
 				PAY.buf[index].is_signed = inst.ldst_sign(); // Load sign is encoded in funct3/width[2] field or inst[14]
-				PAY.buf[index].left = false;
-				PAY.buf[index].right = false;
+				PAY.cold(index).left = false;
+				PAY.cold(index).right = false;
 				break;
 
 			default:
@@ -515,13 +515,13 @@ void pipeline_t::decode() {
 
 		// Insert one or two instructions into the Fetch Queue (indices).
 		FQ.push(index);
-		if (PAY.buf[index].split) {
+		if (PAY.cold(index).split) {
       // Should not come here in current 721sim, with unified int/fp pipeline.
       // Will need this functionality for split-stores, however.
       assert(0);
-			assert(PAY.buf[index+1].split);
-			assert(PAY.buf[index].upper);
-			assert(!PAY.buf[index+1].upper);
+			assert(PAY.cold(index+1).split);
+			assert(PAY.cold(index).upper);
+			assert(!PAY.cold(index+1).upper);
 			FQ.push(index+1);
 		}
 
@@ -67,7 +67,7 @@ void pipeline_t::dispatch() {
          // S_S and S_D are split-stores, i.e., they are split into an addr-op and a value-op.
          // The two ops share a SQ entry to "rejoin". Therefore, only the first op should check
          // for and allocate a SQ entry; the second op should inherit the same entry.
-         if (!PAY.buf[index].split_store || PAY.buf[index].upper) {
+         if (!PAY.cold(index).split_store || PAY.cold(index).upper) {
             bundle_store++;
          }
       }
@@ -244,7 +244,7 @@ void pipeline_t::dispatch() {
             // FIX_ME #10b1 END
 
             // Check if any previous pipeline stage posted an exception.
-            if (PAY.buf[index].trap.valid()) {
+            if (PAY.cold(index).trap.valid()) {
                // *** FIX_ME #10b (part 2): Set exception bit in Active List.
                // FIX_ME #10b2 BEGIN
                 REN->set_exception(PAY.buf[index].AL_index);
@@ -262,13 +262,13 @@ void pipeline_t::dispatch() {
 #ifndef RISCV_ENABLE_FPU
          // Floating-point ISA extension is disabled: illegal instruction exception.
          REN->set_exception(PAY.buf[index].AL_index);
-         PAY.buf[index].trap.post(trap_illegal_instruction());
+         PAY.cold(index).trap.post(trap_illegal_instruction());
 #else
          if (unlikely(!(get_state()->sr & SR_EF))) {
             // Floating-point ISA extension is enabled.
             // The pipeline cannot natively execute FP instructions, however: trap to software FP library.
             REN->set_exception(PAY.buf[index].AL_index);
-            PAY.buf[index].trap.post(trap_fp_disabled());
+            PAY.cold(index).trap.post(trap_fp_disabled());
         }
 #endif
       }
@@ -276,11 +276,11 @@ void pipeline_t::dispatch() {
 
       // Dispatch loads and stores into the LQ/SQ and record their LQ/SQ indices.
       if (IS_MEM_OP(PAY.buf[index].flags)) {
-         if (!PAY.buf[index].split_store || PAY.buf[index].upper) {
+         if (!PAY.cold(index).split_store || PAY.cold(index).upper) {
             LSU.dispatch(IS_LOAD(PAY.buf[index].flags),
                          PAY.buf[index].size,
-                         PAY.buf[index].left,
-                         PAY.buf[index].right,
+                         PAY.cold(index).left,
+                         PAY.cold(index).right,
                          PAY.buf[index].is_signed,
 			 IS_AMO(PAY.buf[index].flags),
                          index,
@@ -288,8 +288,8 @@ void pipeline_t::dispatch() {
                          PAY.buf[index].SQ_index, PAY.buf[index].SQ_phase);
 
             // The lower part of a split-store should inherit the same LSU indices.
-            if (PAY.buf[index].split_store) {
-               assert(PAY.buf[index+1].split && !PAY.buf[index+1].upper);
+            if (PAY.cold(index).split_store) {
+               assert(PAY.cold(index+1).split && !PAY.cold(index+1).upper);
                PAY.buf[index+1].LQ_index = PAY.buf[index].LQ_index;
                PAY.buf[index+1].LQ_phase = PAY.buf[index].LQ_phase;
                PAY.buf[index+1].SQ_index = PAY.buf[index].SQ_index;
@@ -24,7 +24,7 @@ void pipeline_t::execute(unsigned int lane_number) {
       //////////////////////////////////////////////////////////////////////////////////////////////////////////
       if (IS_MEM_OP(PAY.buf[index].flags)) {
          // Perform AGEN to generate address.
-         if (!PAY.buf[index].split_store || PAY.buf[index].upper) {
+         if (!PAY.cold(index).split_store || PAY.cold(index).upper) {
             agen(index);
          }
 
@@ -83,9 +83,9 @@ void pipeline_t::execute(unsigned int lane_number) {
             // Instruction is a store
             assert(IS_STORE(PAY.buf[index].flags));
 
-            if (PAY.buf[index].split_store) {
-               assert(PAY.buf[index].split);
-               if (PAY.buf[index].upper)
+            if (PAY.cold(index).split_store) {
+               assert(PAY.cold(index).split);
+               if (PAY.cold(index).upper)
                   LSU.store_addr(cycle, PAY.buf[index].addr, PAY.buf[index].SQ_index, PAY.buf[index].LQ_index, PAY.buf[index].LQ_phase);    // upper op: address
                else
                   LSU.store_value(PAY.buf[index].SQ_index, PAY.buf[index].A_value.dw);    // lower op: value
@@ -117,7 +117,7 @@ void pipeline_t::execute(unsigned int lane_number) {
             ifprintf(logging_on,execute_log, "Cycle %" PRIcycle ": core %3d: exception refernce thrown from unknown source %s, epc 0x%016" PRIx64 " al_index %u\n", cycle, id, t.name(), epc, al_index);
             // Below is the only three traps the ALU could throw
             assert(t.cause() == CAUSE_FP_DISABLED || t.cause() == CAUSE_ILLEGAL_INSTRUCTION || t.cause() == CAUSE_PRIVILEGED_INSTRUCTION);
-            PAY.buf[index].trap.post(t);
+            PAY.cold(index).trap.post(t);
             REN->set_exception(al_index);
          }
 
@@ -232,8 +232,8 @@ void pipeline_t::load_replay() {
    // FIX_ME #18
    // Replay stalled loads.
    //
-   // There is an autonomous engine that replays one stalled load each cycle in the LSU,
-   // to determine if it can unstall. The code, below, implements the autonomous replay engine.
+   // There is an autonomous engine that replays stalled loads in the LSU, to determine if they can unstall.
+   // Up to LOAD_REPLAY_WIDTH loads can unstall each cycle. The code, below, implements the autonomous replay engine.
    // If the replay succeeds, it means the load finally has a value and we can
    // (1) wakeup its dependents,
    // (2) set the ready bit of its destination register, and
@@ -244,7 +244,7 @@ void pipeline_t::load_replay() {
 
    unsigned int index;
    reg_t value;
-   if (LSU.load_unstall(cycle, index, value)) {
+   for (unsigned int n = 0; (n < LOAD_REPLAY_WIDTH) && LSU.load_unstall(cycle, index, value); n++) {
       // Load has resolved.
       assert(IS_LOAD(PAY.buf[index].flags));
 
@@ -1,4 +1,5 @@
 #include "pipeline.h"
+#include "snapshot.h"
 
 
 // constructor
@@ -53,3 +54,12 @@ void fetch_queue::flush() {
 	tail = 0;
 	length = 0;
 }
+
+// save or restore the fetch queue
+void fetch_queue::snapshot(snapshot_t& s) {
+	s.check(size, "fetch queue size");
+	s.io(q, size);
+	s.io(head);
+	s.io(tail);
+	s.io(length);
+}
@@ -3,6 +3,7 @@
 
 // Forward declaring pipeline_t
 class pipeline_t;
+class snapshot_t;
 
 class fetch_queue {
 private:
@@ -23,6 +24,7 @@ public:
 	unsigned int pop();			// pop an instruction (its payload buffer index) from the fetch queue
 
 	void flush();				// flush the fetch queue (make it empty)
+	void snapshot(snapshot_t& s);		// save or restore the fetch queue
 };
 
 #endif //FETCH_QUEUE_H
@@ -3,6 +3,7 @@
 #include <assert.h>
 #include "CacheClass.h"
 #include "pipeline.h"
+#include "snapshot.h"
 
 
 fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
@@ -84,6 +85,9 @@ fetchunit_t::fetchunit_t(uint64_t instr_per_cycle,			// "n"
    meas_jumpind_seq = 0;// # jump-indirect instructions whose targets were the next sequential PC
 
    meas_btbmiss = 0;	// # of btb misses, i.e., number of discarded fetch bundles (idle fetch cycles) due to a btb miss within the bundle
+
+   // No fetch bundle is being re-formed by warm().
+   warm_pos = instr_per_cycle;
 }
 
 fetchunit_t::~fetchunit_t() {
@@ -138,15 +142,15 @@ void fetchunit_t::transfer_fetch_bundle() {
       PAY->buf[index].fflags = 0; // fflags field is always cleaned for newly fetched instructions
 
       // Clear the trap storage before the first time it is used.
-      PAY->buf[index].trap.clear();
-      assert(!PAY->buf[index].trap.valid());
+      PAY->cold(index).trap.clear();
+      assert(!PAY->cold(index).trap.valid());
 
       // Check if there was an fetch exception.
       if (fetch_bundle[pos].exception) {
          if (fetch_bundle[pos].exception_cause == CAUSE_MISALIGNED_FETCH) {
-            PAY->buf[index].trap.post(trap_instruction_address_misaligned(fetch_bundle[pos].pc));
+            PAY->cold(index).trap.post(trap_instruction_address_misaligned(fetch_bundle[pos].pc));
          } else if (fetch_bundle[pos].exception_cause == CAUSE_FAULT_FETCH) {
-            PAY->buf[index].trap.post(trap_instruction_access_fault(fetch_bundle[pos].pc));
+            PAY->cold(index).trap.post(trap_instruction_access_fault(fetch_bundle[pos].pc));
          } else {
             assert(0);
          }
@@ -342,7 +346,7 @@ bool fetchunit_t::fetch2(pipeline_register DECODE[]) {
       // get PAY index
       index = FETCH2[pos].index;
 
-      if (PAY->buf[index].trap.valid()) {
+      if (PAY->cold(index).trap.valid()) {
          // The instruction triggered an exception during its fetch stage, therefore has a valid trap information.
          exception = true;
 
@@ -761,6 +765,106 @@ void fetchunit_t::flush(uint64_t pc) {
 }
 
 
+// Functional warming.
+// Fetch bundles are re-formed from the actual path, using the same constraints as btb.lookup(), so that the predictors
+// are indexed (by fetch bundle pc and BHRs prior to the fetch bundle) as they would be by fetch1() and commit().
+void fetchunit_t::warm(uint64_t pc, insn_t insn, uint64_t next_pc) {
+   uint64_t target;
+   uint64_t *cb_counters;
+   uint64_t shamt;
+   uint64_t mask;
+   uint64_t ctr;
+   bool taken;
+   bool terminated = false;
+
+   // Start a new fetch bundle, unless this instruction is the next one in the current fetch bundle.
+   if ((warm_pos == instr_per_cycle) || (pc != warm_next_pc)) {
+      warm_pc = pc;
+      warm_pos = 0;
+      warm_num_cb = 0;
+      warm_cb_bhr = cb_index.get_bhr();
+      warm_ib_bhr = ib_index.get_bhr();
+      ic.warm(pc);
+   }
+   warm_pos++;
+   warm_next_pc = next_pc;
+
+   switch (insn.opcode()) {
+      case OP_AMO:
+      case OP_SYSTEM:
+         // Serializing instructions end the fetch bundle.
+         terminated = true;
+         break;
+
+      case OP_JAL:
+      case OP_JALR:
+      case OP_BRANCH:
+         btb.warm(pc, insn);
+         switch (btb_t::decode(insn, pc, target)) {
+            case BTB_BRANCH:
+               // Update the 2-bit counter, as commit() does, then the BHRs, as spec_update() does.
+               taken = (next_pc != INCREMENT_PC(pc));
+	       cb_counters = &(  cb[ cb_index.index(warm_pc, warm_cb_bhr) ]  );
+	       shamt = (warm_num_cb << 1);
+	       mask = (3 << shamt);
+	       ctr = (((*cb_counters) & mask) >> shamt);
+	       if (taken) {
+	          if (ctr < 3)
+	             ctr++;
+	       }
+	       else {
+	          if (ctr > 0)
+	             ctr--;
+	       }
+	       *cb_counters = (((*cb_counters) & (~mask)) | (ctr << shamt));
+
+	       cb_index.update_bhr(taken);
+	       ib_index.update_bhr(taken);
+
+	       warm_num_cb++;
+	       terminated = (taken || (warm_num_cb == cond_branch_per_cycle));
+               break;
+
+            case BTB_JUMP_DIRECT:
+               terminated = true;
+               break;
+
+            case BTB_CALL_DIRECT:
+               ras.push(INCREMENT_PC(pc));
+               terminated = true;
+               break;
+
+            case BTB_JUMP_INDIRECT:
+	       ib[ ib_index.index(warm_pc, warm_ib_bhr) ] = next_pc;
+               terminated = true;
+               break;
+
+            case BTB_CALL_INDIRECT:
+	       ib[ ib_index.index(warm_pc, warm_ib_bhr) ] = next_pc;
+               ras.push(INCREMENT_PC(pc));
+               terminated = true;
+               break;
+
+            case BTB_RETURN:
+               ras.pop();
+               terminated = true;
+               break;
+
+            default:
+               assert(0);
+               break;
+         }
+         break;
+
+      default:
+         break;
+   }
+
+   if (terminated)
+      warm_pos = instr_per_cycle;
+}
+
+
 // Output all branch prediction measurements.
 
 #define BP_OUTPUT(fp, str, n, m, i) \
@@ -791,6 +895,67 @@ uint64_t fetchunit_t::getPC() {
    return(pc);
 }
 
+void fetchunit_t::get_idle_state(bool &fetch2_valid, bool &ic_miss_pending, cycle_t &ic_miss_resolve) {
+   fetch2_valid = fetch2_status.valid;
+   ic_miss_pending = ic_miss;
+   ic_miss_resolve = ic_miss_resolve_cycle;
+}
+
 bool fetchunit_t::active() {
    return(fetch_active);
 }
+
+void fetchunit_t::snapshot(snapshot_t &s) {
+   uint64_t bhr;
+
+   s.check(instr_per_cycle, "fetch width");
+   s.check(cb_index.table_size(), "conditional branch predictor size");
+   s.check(ib_index.table_size(), "indirect branch predictor size");
+
+   // Fetch1 stage.
+   s.io(fetch_active);
+   s.io(pc);
+   s.io(fetch_bundle, instr_per_cycle);
+   s.io(ic_miss);
+   s.io(ic_miss_resolve_cycle);
+   ic.get_cache()->snapshot(s);
+   btb.snapshot(s);
+   s.io(cb, cb_index.table_size());
+   bhr = cb_index.get_bhr();
+   s.io(bhr);
+   cb_index.set_bhr(bhr);
+   s.io(ib, ib_index.table_size());
+   bhr = ib_index.get_bhr();
+   s.io(bhr);
+   ib_index.set_bhr(bhr);
+   ras.snapshot(s);
+
+   // Fetch2 stage.
+   s.io(FETCH2, instr_per_cycle);
+   s.io(fetch2_status);
+   bq.snapshot(s);
+
+   // Measurements and functional warming.
+   measurements(s);
+   s.io(warm_pc);
+   s.io(warm_next_pc);
+   s.io(warm_pos);
+   s.io(warm_num_cb);
+   s.io(warm_cb_bhr);
+   s.io(warm_ib_bhr);
+}
+
+void fetchunit_t::measurements(snapshot_t &s) {
+   s.io(meas_branch_n);
+   s.io(meas_jumpdir_n);
+   s.io(meas_calldir_n);
+   s.io(meas_jumpind_n);
+   s.io(meas_callind_n);
+   s.io(meas_jumpret_n);
+   s.io(meas_branch_m);
+   s.io(meas_jumpind_m);
+   s.io(meas_callind_m);
+   s.io(meas_jumpret_m);
+   s.io(meas_jumpind_seq);
+   s.io(meas_btbmiss);
+}
@@ -10,6 +10,7 @@
 
 // Forward declaring pipeline_t class.
 class pipeline_t;
+class snapshot_t;
 
 
 class fetchunit_t {
@@ -109,6 +110,14 @@ private:
 
 	uint64_t meas_btbmiss;		// # of btb misses, i.e., number of discarded fetch bundles (idle fetch cycles) due to a btb miss within the bundle
 
+	// Functional warming: the fetch bundle that warm() is re-forming from the actual path.
+	uint64_t warm_pc;		// start pc of the fetch bundle
+	uint64_t warm_next_pc;		// pc of the instruction that would continue the fetch bundle
+	uint64_t warm_pos;		// # instructions in the fetch bundle (instr_per_cycle: the fetch bundle has ended)
+	uint64_t warm_num_cb;		// # conditional branches in the fetch bundle
+	uint64_t warm_cb_bhr;		// BHRs just prior to the fetch bundle
+	uint64_t warm_ib_bhr;
+
 	////////////////////////////
 	// Private functions.
 	////////////////////////////
@@ -197,13 +206,32 @@ public:
 	// 6. Reset ic_miss (discard pending I$ misses).
 	void flush(uint64_t pc);
 
+	// Functional warming (see processor_t::warm()).
+	// Train the instruction cache, BTB, conditional and indirect branch predictors, and RAS with an executed instruction and its actual next pc,
+	// as if it had been fetched in a correctly-predicted fetch bundle and committed.  No measurements are updated.
+	void warm(uint64_t pc, insn_t insn, uint64_t next_pc);
+
 	// Output all branch prediction measurements.
 	void output(uint64_t num_instr, uint64_t num_cycles, FILE *fp);
 
+	// Idle-cycle fast-forward support.
+	// Reports whether the Fetch2 stage holds a bundle, and whether the Fetch1 stage is waiting for an instruction cache miss
+	// (and if so, the cycle at which it resolves).
+	void get_idle_state(bool &fetch2_valid, bool &ic_miss_pending, cycle_t &ic_miss_resolve);
+
+	// The instruction cache, for the per-level cache summary in stats.log.
+	CacheClass *get_ic() { return(ic.get_cache()); }
+
 	// Public functions for setting and getting the speculative pc directly.
 	void setPC(uint64_t pc);
 	uint64_t getPC();
 
 	// Public function for querying fetch_active.
 	bool active();
+
+	// Save or restore the Fetch1 and Fetch2 stages, the I$, BTB, branch predictors, RAS, branch queue, and measurements.
+	void snapshot(snapshot_t &s);
+
+	// Save or restore the measurements only (the meas_* counters).
+	void measurements(snapshot_t &s);
 };
@@ -13,6 +13,7 @@
 #include <cmath>
 
 #include "histogram.h"
+#include "snapshot.h"
 
 HistogramClass::HistogramClass(int bins)
 /*------------------------------------------------------------------------*\
@@ -89,6 +90,17 @@ void HistogramClass::Add(int bin, int amount)
 	hist[bin]+=amount;
 }
 
+void HistogramClass::snapshot(snapshot_t& s)
+/*------------------------------------------------------------------------*\
+ | Saves or restores the histogram data (see snapshot.h).
+\*------------------------------------------------------------------------*/
+{
+	s.check(len, "histogram bins");
+	s.io(hist, len);
+	s.io(sum);
+	s.io(sumSq);
+}
+
 void HistogramClass::Clear()
 /*------------------------------------------------------------------------*\
  | Clears out the histogram for reuse.
@@ -3,6 +3,8 @@
 
 #include <iostream>
 
+class snapshot_t;
+
 /*--------------------------------------------------------------------------*\
  | histogram.h
  | Timothy Heil
@@ -98,6 +100,11 @@ public:
 	 | Prints out the histogram data to the output stream specified.
 	\*------------------------------------------------------------------------*/
 
+	void snapshot(snapshot_t& s);
+	/*------------------------------------------------------------------------*\
+	 | Saves or restores the histogram data (see snapshot.h).
+	\*------------------------------------------------------------------------*/
+
 #if 0
 	void PrintStat(ostream& out);
 	/*------------------------------------------------------------------------*\
@@ -93,3 +93,11 @@ bool ic_t::lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &
 
    return(true);	// I$ hit, and the miss_resolve_cycle is a dont-care.
 }
+
+// Functional warming: the two consecutive lines that lookup() accesses for a fetch bundle starting at pc.
+void ic_t::warm(uint64_t pc) {
+   if (!perfect) {
+      IC->Warm(0, ((pc >> line_size) << line_size), false);
+      IC->Warm(0, (((pc >> line_size) + 1) << line_size), false);
+   }
+}
@@ -24,4 +24,9 @@ public:
 	~ic_t();
 
 	bool lookup(cycle_t cycle, uint64_t pc, fetch_bundle_t bundle[], cycle_t &miss_resolve_cycle);
+
+	// Functional warming: reference the lines that lookup() would, with no timing.
+	void warm(uint64_t pc);
+
+	CacheClass *get_cache() { return(IC); }
 };
@@ -0,0 +1,109 @@
+#include "pipeline.h"
+
+
+////////////////////////////////////////////////////////////////////////////////////
+// Idle-cycle fast-forward.
+//
+// Behind a long cache miss, every stage is stalled and a cycle changes nothing but
+// the cycle count, the issue queue's round-robin priority, and a few per-cycle stats.
+//
+// A cycle is idle if the Execution Lanes are empty before and after it, and the idle
+// signature (everything that moves when a stage makes progress) did not change.
+// The following cycles then repeat it exactly, until one of the pipeline's timers
+// expires: a load's or the instruction cache's miss resolves, or the D$ frees an
+// MHSR for a load that was refused one.  So we jump straight to that cycle, applying
+// the idle cycle's stats increments once per skipped cycle.  The stats are identical
+// to stepping cycle-by-cycle.
+//
+// The signature is cheap to get, since it only reads lengths, pointers and counts.
+// Copying the stats counters is not, so they are only copied at the start of a cycle
+// that follows an idle cycle (ff_armed): that cycle is measured, and skipping starts
+// after it.
+////////////////////////////////////////////////////////////////////////////////////
+
+bool pipeline_t::lanes_empty() {
+   for (unsigned int i = 0; i < issue_width; i++) {
+      if (Execution_Lanes[i].rr.valid || Execution_Lanes[i].wb.valid)
+         return(false);
+      for (unsigned int j = 0; j < Execution_Lanes[i].ex_depth; j++) {
+         if (Execution_Lanes[i].ex[j].valid)
+            return(false);
+      }
+   }
+   return(true);
+}
+
+// Fills in the idle signature, and returns the earliest cycle, at or after the
+// current cycle, in which a timer can unstall the pipeline ((cycle_t)-1 if none).
+cycle_t pipeline_t::get_idle_sig(idle_sig_t& sig) {
+   cycle_t event;
+
+   // Zero the padding too, since signatures are compared with memcmp().
+   memset(&sig, 0, sizeof(idle_sig_t));
+
+   sig.pay_head = PAY.head;
+   sig.pay_tail = PAY.tail;
+
+   sig.fetch_pc = FetchUnit->getPC();
+   sig.fetch_active = FetchUnit->active();
+   FetchUnit->get_idle_state(sig.fetch2_valid, sig.ic_miss, sig.ic_miss_resolve);
+
+   sig.decode_valid = DECODE[0].valid;
+   sig.decode_index = DECODE[0].index;
+   sig.fq_length = FQ.get_length();
+   sig.rename2_valid = RENAME2[0].valid;
+   sig.rename2_index = RENAME2[0].index;
+   sig.dispatch_valid = DISPATCH[0].valid;
+   sig.dispatch_index = DISPATCH[0].index;
+
+   sig.iq_length = IQ.get_length();
+   sig.lq_length = LSU.get_lq_length();
+   sig.sq_length = LSU.get_sq_length();
+   event = LSU.next_event(cycle);
+
+   sig.commit_count = counter(commit_count);
+   sig.recovery_count = counter(recovery_count);
+   sig.load_replay_count = LSU.get_replays();
+
+   if (sig.ic_miss && (sig.ic_miss_resolve >= cycle))
+      event = MIN(event, sig.ic_miss_resolve);
+
+   return(event);
+}
+
+// Called at the end of a cycle that started with empty Execution Lanes.
+void pipeline_t::fast_forward() {
+   idle_sig_t sig;
+   cycle_t target;
+   uint64_t n;
+
+   if (!lanes_empty()) {
+      ff_armed = false;
+      return;
+   }
+
+   target = get_idle_sig(sig);
+   if (memcmp(&sig, &ff_sig, sizeof(idle_sig_t)) != 0) {
+      ff_armed = false;
+      return;
+   }
+
+   // Idle, but its stats increments were not measured: measure the next cycle.
+   if (!ff_armed) {
+      ff_armed = true;
+      return;
+   }
+
+   // Don't skip over a progress report/deadlock check or the cycle that turns on logging.
+   target = MIN(target, ((cycle/0x400000) + 1)*0x400000 - 1);
+   target = MIN(target, (cycle_t)logging_on_at);
+
+   if (target <= cycle)
+      return;
+
+   n = (target - cycle);
+   stats->repeat_counters(ff_counters, n);
+   IQ.skip_cycles(n);
+   cycle = target;
+   ff_armed = false;
+}
@@ -1,4 +1,5 @@
 #include "pipeline.h"
+#include "snapshot.h"
 
 
 // constructor
@@ -28,6 +29,13 @@ issue_queue::issue_queue(unsigned int size, unsigned int num_parts, pipeline_t*
 	oldest = -1;
 	youngest = -1;
 
+	// Fast engine: ready bitset is initially empty.
+	// The per-physical-register consumer lists grow on demand as tags are seen.
+	fast = FAST_IQ;
+	age_next = 0;
+	ready_words = ((size + 63) >> 6);
+	ready_bits = new uint64_t[ready_words]();
+
   // Needed for macro
   stats = proc->get_stats();
 }
@@ -69,6 +77,19 @@ void issue_queue::dispatch(unsigned int index, unsigned long long branch_mask, u
 	q[free].D_valid = D_valid;
 	q[free].D_ready = D_ready;
 	q[free].D_tag = D_tag;
+	q[free].age = age_next++;
+
+	if (fast) {
+	   // Subscribe to each distinct, not-yet-ready source tag; or, if all sources are ready, the entry is immediately a select candidate.
+	   if (A_valid && !A_ready)
+	      add_consumer(A_tag, free);
+	   if (B_valid && !B_ready && !(A_valid && !A_ready && (A_tag == B_tag)))
+	      add_consumer(B_tag, free);
+	   if (D_valid && !D_ready && !(A_valid && !A_ready && (A_tag == D_tag)) && !(B_valid && !B_ready && (B_tag == D_tag)))
+	      add_consumer(D_tag, free);
+	   if (entry_ready(free))
+	      SET_BIT(ready_bits[free >> 6], (free & 63));
+	}
 
 	// Add this instruction to tail of linked-list for ideal age-based priority.
 	if (oldest == -1) {	// IQ empty
@@ -88,6 +109,12 @@ void issue_queue::dispatch(unsigned int index, unsigned long long branch_mask, u
 	}
 }
 
+void issue_queue::add_consumer(unsigned int tag, unsigned int i) {
+	if (tag >= consumers.size())
+	   consumers.resize(tag + 1);
+	consumers[tag].push_back({i, q[i].age});
+}
+
 void issue_queue::wakeup(unsigned int tag) {
 	// Broadcast the tag to every entry in the issue queue.
 	// If the broadcasted tag matches a valid tag:
@@ -98,115 +125,190 @@ void issue_queue::wakeup(unsigned int tag) {
 
   inc_counter(wakeup_cam_read_count);
 
+	if (fast) {
+	   // Only the entries that subscribed to this tag at dispatch can match it.
+	   // Skip stale subscriptions (entry since issued or squashed, possibly reused).
+	   if (tag < consumers.size()) {
+	      std::vector<iq_consumer_t>& list = consumers[tag];
+	      for (unsigned int k = 0; k < list.size(); k++) {
+	         unsigned int i = list[k].entry;
+	         if (q[i].valid && (q[i].age == list[k].age))
+	            wakeup_entry(i, tag);
+	      }
+	      list.clear();
+	   }
+	   return;
+	}
+
 	for (unsigned int i = 0; i < size; i++) {
 		if (q[i].valid) {					// Only consider valid issue queue entries.
-			if (q[i].A_valid && (tag == q[i].A_tag)) {	// Check first source operand.
-				assert(!q[i].A_ready);
-				q[i].A_ready = true;
+			wakeup_entry(i, tag);
+		}
+	}
+}
+
+void issue_queue::wakeup_entry(unsigned int i, unsigned int tag) {
+	if (q[i].A_valid && (tag == q[i].A_tag)) {	// Check first source operand.
+		assert(!q[i].A_ready);
+		q[i].A_ready = true;
         #ifdef RISCV_MICRO_DEBUG
           LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS1 iq entry %u",i);
           dump_iq(proc,i,proc->issue_log);
         #endif
 
-			}
-			if (q[i].B_valid && (tag == q[i].B_tag)) {	// Check second source operand.
-				assert(!q[i].B_ready);
-				q[i].B_ready = true;
+	}
+	if (q[i].B_valid && (tag == q[i].B_tag)) {	// Check second source operand.
+		assert(!q[i].B_ready);
+		q[i].B_ready = true;
         #ifdef RISCV_MICRO_DEBUG
           LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS2 iq entry %u",i);
           dump_iq(proc,i,proc->issue_log);
         #endif
-			}
-			if (q[i].D_valid && (tag == q[i].D_tag)) {	// Check third source operand.
-				assert(!q[i].D_ready);
-				q[i].D_ready = true;
+	}
+	if (q[i].D_valid && (tag == q[i].D_tag)) {	// Check third source operand.
+		assert(!q[i].D_ready);
+		q[i].D_ready = true;
         #ifdef RISCV_MICRO_DEBUG
           LOG(proc->issue_log,proc->cycle,proc->PAY.buf[q[i].index].sequence,proc->PAY.buf[q[i].index].pc,"Waking up RS3 iq entry %u",i);
           dump_iq(proc,i,proc->issue_log);
         #endif
-			}
-		}
 	}
+	if (fast && entry_ready(i))
+	   SET_BIT(ready_bits[i >> 6], (i & 63));
 }
 
-void issue_queue::select_and_issue(unsigned int num_lanes, lane* Execution_Lanes) {
-   unsigned int i, j;
+bool issue_queue::try_issue(unsigned int i, unsigned int num_lanes, lane* Execution_Lanes) {
    bool issue;
    unsigned int dyn_lane_id;
-   bool issuedThisCycle = false;
 
-   // Set up the first IQ index to be examined this cycle.
-   if (IDEAL_AGE_BASED) {
-      if (oldest == -1) { // IQ empty, so no age-based list to sequence through.
-         assert(youngest == -1);
-	 assert(length == 0);
-         return;
-      }
-      else {
-         i = (unsigned int)oldest;  // Start sequencing at oldest instruction in the IQ.
-      }
+   if (PRESTEER) {
+      // Check if the instruction's desired Execution Lane is free.
+      issue = !Execution_Lanes[q[i].lane_id].rr.valid;
    }
    else {
-      i = part_next;
+      // Check if there is a free Execution Lane among all candidate lanes.
+      issue = false;
+      dyn_lane_id = 0;
+      while (!issue && (dyn_lane_id < num_lanes)) {
+         if ((q[i].lane_id & (1 << dyn_lane_id)) && !Execution_Lanes[dyn_lane_id].rr.valid) {
+            issue = true;
+            q[i].lane_id = dyn_lane_id;
+         }
+         else {
+            dyn_lane_id++;
+         }
+      }
    }
 
-   // The same 'j' loop supports both of the following modes:
-   // - scan the entire IQ sequentially from the first index i
-   // - scan valid IQ entries in age-order from the first (oldest) index i
-   for (j = 0; j < size; j++) {
-      assert(!IDEAL_AGE_BASED || q[i].valid);
- 
-      // Check if the instruction is valid and ready.
-      if (q[i].valid && (!q[i].A_valid || q[i].A_ready) && (!q[i].B_valid || q[i].B_ready) && (!q[i].D_valid || q[i].D_ready)) {
-         if (PRESTEER) {
-            // Check if the instruction's desired Execution Lane is free.
-	    issue = !Execution_Lanes[q[i].lane_id].rr.valid;
-	 }
-	 else {
-	    // Check if there is a free Execution Lane among all candidate lanes.
-            issue = false;
-	    dyn_lane_id = 0;
-	    while (!issue && (dyn_lane_id < num_lanes)) {
-	       if ((q[i].lane_id & (1 << dyn_lane_id)) && !Execution_Lanes[dyn_lane_id].rr.valid) {
-		  issue = true;
-                  q[i].lane_id = dyn_lane_id;
-	       }
-	       else {
-	          dyn_lane_id++;
-	       }
-	    }
-         }
+   if (issue) {
+      assert(q[i].lane_id < num_lanes);
+      assert(!Execution_Lanes[q[i].lane_id].rr.valid);
 
-	 if (issue) {
-            assert(q[i].lane_id < num_lanes);
-            assert(!Execution_Lanes[q[i].lane_id].rr.valid);
+      // Issue the instruction to the Register Read Stage within the Execution Lane.
+      Execution_Lanes[q[i].lane_id].rr.valid = true;
+      Execution_Lanes[q[i].lane_id].rr.index = q[i].index;
+      Execution_Lanes[q[i].lane_id].rr.branch_mask = q[i].branch_mask;
 
-            // Issue the instruction to the Register Read Stage within the Execution Lane.
-            Execution_Lanes[q[i].lane_id].rr.valid = true;
-            Execution_Lanes[q[i].lane_id].rr.index = q[i].index;
-            Execution_Lanes[q[i].lane_id].rr.branch_mask = q[i].branch_mask;
+      // Remove the instruction from the issue queue.
+      remove(i);
 
-            // Remove the instruction from the issue queue.
-            remove(i);
-   
-            issuedThisCycle = true;
-            inc_counter(issued_inst_count);
-         }
+      inc_counter(issued_inst_count);
+   }
+
+   return(issue);
+}
+
+int issue_queue::next_ready(unsigned int from, unsigned int end) {
+   while (from < end) {
+      unsigned int w = (from >> 6);
+      uint64_t bits = (ready_bits[w] & (~0ULL << (from & 63)));
+      if (bits) {
+         unsigned int i = ((w << 6) + __builtin_ctzll(bits));
+         return((i < end) ? (int)i : -1);
       }
+      from = ((w + 1) << 6);
+   }
+   return(-1);
+}
 
+void issue_queue::select_and_issue(unsigned int num_lanes, lane* Execution_Lanes) {
+   unsigned int i, j;
+   int r;
+   bool issuedThisCycle = false;
+
+   if (fast) {
+      if (IDEAL_AGE_BASED) {
+         if (oldest == -1) // IQ empty
+            return;
+
+         // Gather the ready entries and visit them oldest first, i.e., in the order of the age-based linked list.
+         ready_list.clear();
+         for (r = next_ready(0, size); r != -1; r = next_ready((unsigned int)r + 1, size)) {
+            unsigned int k = ready_list.size();
+            ready_list.push_back((unsigned int)r);
+            while ((k > 0) && (q[ready_list[k-1]].age > q[r].age)) {	// insertion sort: few entries are ready at once
+               ready_list[k] = ready_list[k-1];
+               k--;
+            }
+            ready_list[k] = (unsigned int)r;
+         }
+         for (j = 0; j < ready_list.size(); j++)
+            if (try_issue(ready_list[j], num_lanes, Execution_Lanes))
+               issuedThisCycle = true;
+      }
+      else {
+         // Visit the ready entries in sequential order, starting at the partition that has priority and wrapping around.
+         // Issuing only clears the ready bits of entries already visited.
+         for (r = next_ready(part_next, size); r != -1; r = next_ready((unsigned int)r + 1, size))
+            if (try_issue((unsigned int)r, num_lanes, Execution_Lanes))
+               issuedThisCycle = true;
+         for (r = next_ready(0, part_next); r != -1; r = next_ready((unsigned int)r + 1, part_next))
+            if (try_issue((unsigned int)r, num_lanes, Execution_Lanes))
+               issuedThisCycle = true;
+      }
+   }
+   else {
+      // Set up the first IQ index to be examined this cycle.
       if (IDEAL_AGE_BASED) {
-	 // Set q index to that of the next-oldest instruction, or break from loop if there is no next-oldest instruction.
-	 // Note: even if we issued and removed i from the IQ, above, its next pointer is still available.
-         if (q[i].next == -1)
-	    break;
-         else
-	    i = (unsigned int)q[i].next;
+         if (oldest == -1) { // IQ empty, so no age-based list to sequence through.
+            assert(youngest == -1);
+            assert(length == 0);
+            return;
+         }
+         else {
+            i = (unsigned int)oldest;  // Start sequencing at oldest instruction in the IQ.
+         }
       }
       else {
-         // Modulo increment q index.
-         i++;
-         if (i == size)
-            i = 0;
+         i = part_next;
+      }
+
+      // The same 'j' loop supports both of the following modes:
+      // - scan the entire IQ sequentially from the first index i
+      // - scan valid IQ entries in age-order from the first (oldest) index i
+      for (j = 0; j < size; j++) {
+         assert(!IDEAL_AGE_BASED || q[i].valid);
+
+         // Check if the instruction is valid and ready.
+         if (q[i].valid && entry_ready(i)) {
+            if (try_issue(i, num_lanes, Execution_Lanes))
+               issuedThisCycle = true;
+         }
+
+         if (IDEAL_AGE_BASED) {
+            // Set q index to that of the next-oldest instruction, or break from loop if there is no next-oldest instruction.
+            // Note: even if we issued and removed i from the IQ, above, its next pointer is still available.
+            if (q[i].next == -1)
+               break;
+            else
+               i = (unsigned int)q[i].next;
+         }
+         else {
+            // Modulo increment q index.
+            i++;
+            if (i == size)
+               i = 0;
+         }
       }
    }
 
@@ -219,6 +321,12 @@ void issue_queue::select_and_issue(unsigned int num_lanes, lane* Execution_Lanes
       part_next = 0;
 }
 
+// Account for 'n' cycles in which nothing issued: only the round-robin partition priority moves.
+void issue_queue::skip_cycles(uint64_t n) {
+   unsigned int num_parts = (size/part_size);
+   part_next = (unsigned int)((part_next/part_size + n) % num_parts) * part_size;
+}
+
 void issue_queue::remove(unsigned int i) {
 	assert(length > 0);
 	assert(fl_length < size);
@@ -226,6 +334,7 @@ void issue_queue::remove(unsigned int i) {
 	// Remove the instruction from the issue queue.
 	q[i].valid = false;
 	length--;
+	CLEAR_BIT(ready_bits[i >> 6], (i & 63));
 
 	// Push the issue queue entry back onto the free list.
 	fl[fl_tail] = i;
@@ -280,6 +389,13 @@ void issue_queue::flush() {
 
 	oldest = -1;
 	youngest = -1;
+
+	for (unsigned int w = 0; w < ready_words; w++) {
+		ready_bits[w] = 0;
+	}
+	for (unsigned int tag = 0; tag < consumers.size(); tag++) {
+		consumers[tag].clear();
+	}
 }
 
 void issue_queue::clear_branch_bit(unsigned int branch_ID) {
@@ -320,3 +436,26 @@ void issue_queue::dump_iq(pipeline_t* proc, unsigned int index,FILE* file)
   ifprintf(logging_on,file,"\n");
 }
 
+
+void issue_queue::snapshot(snapshot_t& s) {
+	s.check(size, "issue queue size");
+	s.check(part_size, "issue queue partition size");
+	s.check(fast, "fast issue queue");
+	s.io(q, size);
+	s.io(length);
+	s.io(part_next);
+	s.io(oldest);
+	s.io(youngest);
+	s.io(fl, size);
+	s.io(fl_head);
+	s.io(fl_tail);
+	s.io(fl_length);
+	s.io(age_next);
+	s.io(ready_bits, ready_words);
+
+	uint64_t n = consumers.size();
+	s.io(n);
+	consumers.resize(n);
+	for (uint64_t i = 0; i < n; i++)
+		s.io(consumers[i]);
+}
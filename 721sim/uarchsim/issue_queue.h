@@ -35,13 +35,24 @@ typedef struct {
 	int prev;	// IQ index of previous-oldest instruction still in the IQ.
 	int next;	// IQ index of next-oldest instruction still in the IQ.
 
+	// Dispatch order of the instruction: used by the fast engine to recover age order and to detect stale consumer list entries.
+	uint64_t age;
+
 } issue_queue_entry_t;
 
+// Entry in a physical register's consumer list (fast engine).
+// The list entry is stale if the IQ entry has since been freed or reused, i.e., its age no longer matches.
+typedef struct {
+	unsigned int entry;	// IQ index of the consumer
+	uint64_t age;		// age of the consumer when it was added to the list
+} iq_consumer_t;
+
 
 //Forward declaring classes
 class pipeline_t;
 class payload;
 class stats_t;
+class snapshot_t;
 
 class issue_queue {
 private:
@@ -65,8 +76,25 @@ private:
 	unsigned int fl_tail;		// Tail of issue queue's free list.
 	unsigned int fl_length;			// Length of issue queue's free list.
 
+	// Fast engine (FAST_IQ):
+	// - wakeup visits only the consumers of the broadcasted tag, instead of every IQ entry
+	// - select visits only ready entries, found by scanning a ready bitset with count-trailing-zeros
+	// Issue order and stats are identical to the sequential scans.
+	bool fast;
+	uint64_t age_next;				// age assigned to the next dispatched instruction
+	uint64_t* ready_bits;				// bit i is set iff IQ entry i is valid and all of its source operands are ready
+	unsigned int ready_words;			// number of 64-bit words in ready_bits
+	std::vector< std::vector<iq_consumer_t> > consumers;	// per physical register: IQ entries waiting on it
+	std::vector<unsigned int> ready_list;		// scratch: ready entries in age order (ideal age-based priority)
+
 	void remove(unsigned int i);	// Remove the instruction in issue queue entry 'i' from the issue queue.
 
+	bool entry_ready(unsigned int i) { return((!q[i].A_valid || q[i].A_ready) && (!q[i].B_valid || q[i].B_ready) && (!q[i].D_valid || q[i].D_ready)); }
+	void add_consumer(unsigned int tag, unsigned int i);
+	void wakeup_entry(unsigned int i, unsigned int tag);	// Set the ready bits of entry i's source operands that match the tag.
+	int next_ready(unsigned int from, unsigned int end);	// Lowest ready IQ index in [from, end), or -1 if none.
+	bool try_issue(unsigned int i, unsigned int num_lanes, lane* Execution_Lanes);	// Try to issue entry i to a free Execution Lane.
+
 
 public:
 	issue_queue(unsigned int size, unsigned int num_parts, pipeline_t* _proc=NULL);	// constructor
@@ -78,9 +106,12 @@ public:
 	void wakeup(unsigned int tag);
 	void select_and_issue(unsigned int num_lanes, lane* Execution_Lanes);
 	void flush();
+	unsigned int get_length() { return(length); }
+	void skip_cycles(uint64_t n);
 	void clear_branch_bit(unsigned int branch_ID);
 	void squash(unsigned int branch_ID);
   void dump_iq(pipeline_t* proc, unsigned int index,FILE* file=stderr);
+	void snapshot(snapshot_t& s);	// Save or restore the issue queue, its free list, and the fast engine's state.
 };
 
 #endif //ISSUE_QUEUE_H
@@ -1,4 +1,5 @@
 #include "pipeline.h"
+#include "snapshot.h"
 
 
 lane::lane() {
@@ -16,3 +17,10 @@ void lane::init(unsigned int ex_depth) {
 	  ex[i].valid = false;
 	wb.valid = false;
 }
+
+void lane::snapshot(snapshot_t& s) {
+	s.io(rr);
+	s.check(ex_depth, "execution lane depth");
+	s.io(ex, ex_depth);
+	s.io(wb);
+}
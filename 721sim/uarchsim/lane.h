@@ -1,6 +1,8 @@
 #ifndef LANE_H
 #define LANE_H
 
+class snapshot_t;
+
 class lane {
 public:
 	pipeline_register rr;	// pipeline register of Register Read Stage
@@ -11,6 +13,7 @@ public:
 
 	lane();	// constructor
 	void init(unsigned int ex_depth);
+	void snapshot(snapshot_t& s);	// save or restore the lane's pipeline registers
 };
 
 #endif //LANE_H
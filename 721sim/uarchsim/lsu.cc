@@ -5,8 +5,172 @@
 #include "mmu.h"
 #include "pipeline.h"
 #include "trap.h"
+#include "snapshot.h"
 
 
+// Hash an address to its 8-byte granule's chain.
+static inline unsigned int lsq_hash(reg_t addr, unsigned int hash_mask) {
+	return((unsigned int)(((addr >> 3) * 0x9E3779B97F4A7C15ULL) >> 32) & hash_mask);
+}
+
+void lsu::index_insert(lsq_entry* Q, int* bucket, unsigned int hash_mask, unsigned int entry) {
+	unsigned int b = lsq_hash(Q[entry].addr, hash_mask);
+
+	assert(!Q[entry].indexed);
+	Q[entry].indexed = true;
+	Q[entry].hash_prev = -1;
+	Q[entry].hash_next = bucket[b];
+	if (bucket[b] != -1)
+		Q[bucket[b]].hash_prev = entry;
+	bucket[b] = entry;
+}
+
+void lsu::index_remove(lsq_entry* Q, int* bucket, unsigned int hash_mask, unsigned int entry) {
+	assert(Q[entry].indexed);
+	Q[entry].indexed = false;
+	if (Q[entry].hash_prev != -1)
+		Q[Q[entry].hash_prev].hash_next = Q[entry].hash_next;
+	else
+		bucket[lsq_hash(Q[entry].addr, hash_mask)] = Q[entry].hash_next;
+	if (Q[entry].hash_next != -1)
+		Q[Q[entry].hash_next].hash_prev = Q[entry].hash_prev;
+}
+
+void lsu::set_sq_unknown(unsigned int entry, bool unknown) {
+	if (unknown != BIT_IS_ONE(sq_unknown_bits[entry >> 6], (entry & 63))) {
+		if (unknown) {
+			SET_BIT(sq_unknown_bits[entry >> 6], (entry & 63));
+			sq_unknown++;
+		}
+		else {
+			CLEAR_BIT(sq_unknown_bits[entry >> 6], (entry & 63));
+			sq_unknown--;
+		}
+	}
+}
+
+// Highest set bit in [lo, hi) of a bit vector, or -1 if none.
+static int highest_set_bit(uint64_t* bits, unsigned int lo, unsigned int hi) {
+	while (hi > lo) {
+		unsigned int w = ((hi - 1) >> 6);
+		uint64_t word = bits[w];
+		if ((hi & 63) != 0)
+			word &= ((1ULL << (hi & 63)) - 1);	// drop bits at or above hi
+		if (word) {
+			int i = (int)((w << 6) + 63 - __builtin_clzll(word));
+			return((i >= (int)lo) ? i : -1);
+		}
+		hi = (w << 6);
+	}
+	return(-1);
+}
+
+// Lowest set bit in [lo, hi) of a bit vector, or -1 if none.
+static int lowest_set_bit(uint64_t* bits, unsigned int lo, unsigned int hi) {
+	while (lo < hi) {
+		unsigned int w = (lo >> 6);
+		uint64_t word = (bits[w] & (~0ULL << (lo & 63)));	// drop bits below lo
+		if (word) {
+			int i = (int)((w << 6) + __builtin_ctzll(word));
+			return((i < (int)hi) ? i : -1);
+		}
+		lo = ((w + 1) << 6);
+	}
+	return(-1);
+}
+
+int lsu::youngest_unknown_store(unsigned int sq_index) {
+	int entry;
+
+	// The stores prior to the load occupy SQ indices [sq_head, sq_index), possibly wrapping around.
+	if (sq_head < sq_index)
+		return(highest_set_bit(sq_unknown_bits, sq_head, sq_index));
+	entry = highest_set_bit(sq_unknown_bits, 0, sq_index);
+	if (entry == -1)
+		entry = highest_set_bit(sq_unknown_bits, sq_head, sq_size);
+	return(entry);
+}
+
+// Park a stalled load on the wait lists of whatever blocks it (see execute_load()).
+void lsu::park_load(cycle_t cycle, unsigned int lq_index) {
+	load_waiter_t w;
+	load_timer_t t;
+
+	assert(LQ[lq_index].valid && LQ[lq_index].addr_avail && !LQ[lq_index].value_avail);
+
+	LQ[lq_index].wait_gen++;
+	w.lq_index = lq_index;
+	w.gen = LQ[lq_index].wait_gen;
+	t.lq_index = lq_index;
+	t.gen = w.gen;
+
+	// A load that was refused an MHSR retries the D$ when it is replayed, whatever else it waits for.
+	if (!PERFECT_DCACHE && (LQ[lq_index].miss_resolve_cycle == (cycle_t)-1)) {
+		mhsr_waiters.push_back(w);
+		t.cycle = DC->NextFreeMHSR(cycle);
+		load_timers.push(t);
+	}
+
+	switch (LQ[lq_index].wait) {
+		case LOAD_WAIT_HEAD:
+			// Woken by commit().
+			break;
+		case LOAD_WAIT_STORE:
+			sq_waiters[LQ[lq_index].wait_store].push_back(w);
+			break;
+		case LOAD_WAIT_MISS:
+			if (LQ[lq_index].miss_resolve_cycle != (cycle_t)-1) {
+				t.cycle = LQ[lq_index].miss_resolve_cycle;
+				load_timers.push(t);
+			}
+			break;
+		default:
+			assert(0);
+			break;
+	}
+}
+
+// Mark a stalled load for replay. This invalidates its remaining wait list entries.
+void lsu::wake_load(unsigned int lq_index) {
+	if (!BIT_IS_ONE(lq_ready_bits[lq_index >> 6], (lq_index & 63))) {
+		SET_BIT(lq_ready_bits[lq_index >> 6], (lq_index & 63));
+		lq_ready++;
+		LQ[lq_index].wait_gen++;
+	}
+}
+
+void lsu::wake_waiters(std::vector<load_waiter_t>& waiters) {
+	for (unsigned int k = 0; k < waiters.size(); k++) {
+		unsigned int i = waiters[k].lq_index;
+		if (LQ[i].valid && (LQ[i].wait_gen == waiters[k].gen))
+			wake_load(i);
+	}
+	waiters.clear();
+}
+
+// A store's address just became known: wake the stalled loads after it whose addresses match.
+// Their disambiguation outcome may change, whatever they were waiting for.
+void lsu::wake_matching_loads(unsigned int sq_index, unsigned int lq_index, bool lq_index_phase) {
+	uint64_t max_size;
+	uint64_t mask;
+	unsigned int n_after;
+	unsigned int pos;
+
+	n_after = MOD_S((lq_tail + lq_size - lq_index), lq_size);
+	if ((n_after == 0) && (lq_index_phase != lq_tail_phase))
+		n_after = lq_size;
+
+	for (int e = lq_bucket[lsq_hash(SQ[sq_index].addr, lq_hash_mask)]; e != -1; e = LQ[e].hash_next) {
+		pos = MOD_S((e + lq_size - lq_index), lq_size);
+		if ((pos < n_after) && !LQ[e].value_avail) {
+			max_size = MAX(SQ[sq_index].size, LQ[e].size);
+			mask = (~(max_size - 1));
+			if ((SQ[sq_index].addr & mask) == (LQ[e].addr & mask))
+				wake_load(e);
+		}
+	}
+}
+
 bool lsu::disambiguate(unsigned int lq_index,
                        unsigned int sq_index, bool sq_index_phase,
                        bool& forward,
@@ -14,47 +178,69 @@ bool lsu::disambiguate(unsigned int lq_index,
 	bool stall;		// return value
 	uint64_t max_size;
 	uint64_t mask;
+	unsigned int n_prior;	// number of stores prior to the load
+	unsigned int pos;	// age of a store: position relative to the SQ head
+	int match;		// youngest prior store whose known address conflicts with the load
+	unsigned int match_pos;
+	int unknown;		// youngest prior store whose address is unknown
+
+	stall = false;
+	forward = false;
 
 	// Check if the load is logically at the head of the SQ, i.e., no prior stores.
 	if ((sq_index == sq_head) && (sq_index_phase == sq_head_phase)) {
 		// There are no stores prior to the load.
-		stall = false;
-		forward = false;
+		return(stall);
 	}
-	else {
-		stall = false;
-		forward = false;
-
-		// Because the load is not logically at the head of the SQ,
-		// it must be true that the SQ has at least one store.
-		assert(sq_length > 0);
 
-		store_entry = sq_index;
-		do {
-			store_entry = MOD_S((store_entry + sq_size - 1), sq_size);
-
-			max_size = MAX(SQ[store_entry].size, LQ[lq_index].size);
+	// Because the load is not logically at the head of the SQ,
+	// it must be true that the SQ has at least one store.
+	assert(sq_length > 0);
+
+	n_prior = MOD_S((sq_index + sq_size - sq_head), sq_size);
+	if (n_prior == 0)
+		n_prior = sq_size;
+
+	// Find the youngest prior store with a conflicting address.
+	// Only stores in the load's hash chain can conflict.
+	match = -1;
+	match_pos = 0;
+	for (int e = sq_bucket[lsq_hash(LQ[lq_index].addr, sq_hash_mask)]; e != -1; e = SQ[e].hash_next) {
+		pos = MOD_S((e + sq_size - sq_head), sq_size);
+		if ((pos < n_prior) && ((match == -1) || (pos > match_pos))) {
+			max_size = MAX(SQ[e].size, LQ[lq_index].size);
 			mask = (~(max_size - 1));
-
-			if (!SQ[store_entry].addr_avail) {
-				stall = LQ[lq_index].mdp_stall;  // stall (if prediction says to): possible conflict
-				if (stall)
-				   LQ[lq_index].stat_load_stall_disambig_addrunknown = true;
+			if ((SQ[e].addr & mask) == (LQ[lq_index].addr & mask)) {
+				match = e;
+				match_pos = pos;
 			}
-			else if ((SQ[store_entry].addr & mask) ==
-			         (LQ[lq_index].addr    & mask)) {
-				// There is a conflict.
-				if (SQ[store_entry].size != LQ[lq_index].size) {
-					stall = true;    // stall: partial conflict scenarios are hard
-				}
-				else if (!SQ[store_entry].value_avail) {
-					stall = true;    // stall: must wait for value to be available
-				}
-				else {
-					forward = true;    // forward: sizes match and value is available
-				}
-			}
-		} while ((store_entry != sq_head) && !stall && !forward);
+		}
+	}
+
+	// A prior store with an unknown address, younger than the conflicting store (if any),
+	// is a possible conflict: stall if the prediction says to.
+	if (LQ[lq_index].mdp_stall && (sq_unknown > 0)) {
+		unknown = youngest_unknown_store(sq_index);
+		if ((unknown != -1) && ((match == -1) || (MOD_S((unknown + sq_size - sq_head), sq_size) > match_pos))) {
+			stall = true;
+			LQ[lq_index].stat_load_stall_disambig_addrunknown = true;
+			store_entry = unknown;
+			return(stall);
+		}
+	}
+
+	if (match != -1) {
+		// There is a conflict.
+		store_entry = match;
+		if (SQ[store_entry].size != LQ[lq_index].size) {
+			stall = true;    // stall: partial conflict scenarios are hard
+		}
+		else if (!SQ[store_entry].value_avail) {
+			stall = true;    // stall: must wait for value to be available
+		}
+		else {
+			forward = true;    // forward: sizes match and value is available
+		}
 	}
 
 	return(stall);
@@ -63,40 +249,52 @@ bool lsu::disambiguate(unsigned int lq_index,
 bool lsu::ld_violation(unsigned int sq_index,
                        unsigned int lq_index, bool lq_index_phase,
                        unsigned int& load_entry) {
-   bool misp;
-   bool load_entry_phase;
    uint64_t max_size;
    uint64_t mask;
-   bool match;
-
-   misp = false;
-   load_entry = lq_index;
-   load_entry_phase = lq_index_phase;
-
-   // Search the LQ from the first load after the store (if it exists) to the tail.
-   while (!misp && !((load_entry == lq_tail) && (load_entry_phase == lq_tail_phase))) {
-      max_size = MAX(SQ[sq_index].size, LQ[load_entry].size);
-      mask = (~(max_size - 1));
-
-      match = (LQ[load_entry].addr_avail && ((SQ[sq_index].addr & mask) == (LQ[load_entry].addr & mask)));
-
-      if (match && LQ[load_entry].value_avail) {
-         misp = true;
-	 // STATS, and feedback to the memory dependence predictor.
-	 LQ[load_entry].stat_load_violation = true;
+   unsigned int n_after;	// number of loads after the store
+   unsigned int pos;		// age of a load: position relative to the first load after the store
+   int misp_entry;		// oldest load after the store that conflicts and already has its value
+   unsigned int misp_pos;
+
+   // The loads after the store (if they exist) occupy the LQ from lq_index to the tail.
+   n_after = MOD_S((lq_tail + lq_size - lq_index), lq_size);
+   if ((n_after == 0) && (lq_index_phase != lq_tail_phase))
+      n_after = lq_size;
+
+   // Only loads in the store's hash chain can conflict. A load conflicts if its address is known and matches.
+   // The oldest conflicting load whose value is available is a load violation.
+   misp_entry = -1;
+   misp_pos = 0;
+   for (int e = lq_bucket[lsq_hash(SQ[sq_index].addr, lq_hash_mask)]; e != -1; e = LQ[e].hash_next) {
+      pos = MOD_S((e + lq_size - lq_index), lq_size);
+      if ((pos < n_after) && LQ[e].value_avail && ((misp_entry == -1) || (pos < misp_pos))) {
+         max_size = MAX(SQ[sq_index].size, LQ[e].size);
+         mask = (~(max_size - 1));
+         if ((SQ[sq_index].addr & mask) == (LQ[e].addr & mask)) {
+            misp_entry = e;
+            misp_pos = pos;
+         }
       }
-      else {
-	 // STATS, and feedback to the memory dependence predictor.
-         if (match)
-	    LQ[load_entry].stat_late_store_match = true;
+   }
 
-         load_entry = MOD_S((load_entry + 1), lq_size);
-         if (load_entry == 0)   // wrapped around, so toggle phase bit
-            load_entry_phase = !load_entry_phase;
+   // STATS, and feedback to the memory dependence predictor.
+   // Conflicting loads older than the load violation (or all of them, if none) are still stalled: late store match.
+   for (int e = lq_bucket[lsq_hash(SQ[sq_index].addr, lq_hash_mask)]; e != -1; e = LQ[e].hash_next) {
+      pos = MOD_S((e + lq_size - lq_index), lq_size);
+      if ((pos < n_after) && ((misp_entry == -1) || (pos < misp_pos))) {
+         max_size = MAX(SQ[sq_index].size, LQ[e].size);
+         mask = (~(max_size - 1));
+         if ((SQ[sq_index].addr & mask) == (LQ[e].addr & mask))
+            LQ[e].stat_late_store_match = true;
       }
    }
 
-   return(misp);
+   if (misp_entry != -1) {
+      load_entry = misp_entry;
+      LQ[load_entry].stat_load_violation = true;
+   }
+
+   return(misp_entry != -1);
 } // ld_violation()
 
 void lsu::set_l2_cache(CacheClass* l2_dc){
@@ -133,6 +331,8 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
 	LQ = new lsq_entry[lq_size];
 	for (unsigned int i = 0; i < lq_size; i++) {
 		LQ[i].valid = false;
+		LQ[i].indexed = false;
+		LQ[i].wait_gen = 0;
 	}
 
 	// SQ initialization.
@@ -146,8 +346,31 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
 	SQ = new lsq_entry[sq_size];
 	for (unsigned int i = 0; i < sq_size; i++) {
 		SQ[i].valid = false;
+		SQ[i].indexed = false;
   }
 
+	// Address index initialization: at least two hash chains per queue entry.
+	for (lq_hash_mask = 1; lq_hash_mask < (2 * lq_size); lq_hash_mask <<= 1);
+	lq_bucket = new int[lq_hash_mask];
+	lq_hash_mask--;
+	for (unsigned int i = 0; i <= lq_hash_mask; i++)
+		lq_bucket[i] = -1;
+
+	for (sq_hash_mask = 1; sq_hash_mask < (2 * sq_size); sq_hash_mask <<= 1);
+	sq_bucket = new int[sq_hash_mask];
+	sq_hash_mask--;
+	for (unsigned int i = 0; i <= sq_hash_mask; i++)
+		sq_bucket[i] = -1;
+
+	sq_unknown = 0;
+	sq_unknown_bits = new uint64_t[(sq_size + 63) >> 6]();
+
+	// Load replay initialization: no stalled loads.
+	lq_ready_bits = new uint64_t[(lq_size + 63) >> 6]();
+	lq_ready = 0;
+	sq_waiters = new std::vector<load_waiter_t>[sq_size];
+	n_replay = 0;
+
 	// STATS
 	n_stall_disambig = 0;
 	n_forward = 0;
@@ -162,6 +385,11 @@ lsu::lsu(unsigned int lq_size, unsigned int sq_size, unsigned int Tid, mmu_t* _m
 
 lsu::~lsu(){
   delete DC;
+  delete [] lq_bucket;
+  delete [] sq_bucket;
+  delete [] sq_unknown_bits;
+  delete [] lq_ready_bits;
+  delete [] sq_waiters;
 }
 
 bool lsu::stall(unsigned int bundle_load, unsigned int bundle_store) {
@@ -193,7 +421,10 @@ void lsu::dispatch(bool load,
 		assert(lq_length < lq_size);
 
 		// Allocate entry in the LQ.
+		assert(!LQ[lq_tail].indexed);
+		assert(!BIT_IS_ONE(lq_ready_bits[lq_tail >> 6], (lq_tail & 63)));
 		LQ[lq_tail].valid = true;
+		LQ[lq_tail].wait_gen++;	// invalidate wait list entries of a squashed load
 		LQ[lq_tail].is_signed = is_signed;
 		//LQ[lq_tail].left = left;
 		//LQ[lq_tail].right = right;
@@ -238,6 +469,9 @@ void lsu::dispatch(bool load,
 		assert(sq_length < sq_size);
 
 		// Allocate entry in the SQ.
+		assert(!SQ[sq_tail].indexed);
+		set_sq_unknown(sq_tail, true);
+		sq_waiters[sq_tail].clear();	// drop wait list entries of squashed loads
 		SQ[sq_tail].valid = true;
 		SQ[sq_tail].is_signed = is_signed;
 		//SQ[sq_tail].left = left;
@@ -304,6 +538,12 @@ void lsu::store_addr(cycle_t cycle,
 
    SQ[sq_index].addr_avail = true;
    SQ[sq_index].addr = addr;
+   set_sq_unknown(sq_index, false);
+   index_insert(SQ, sq_bucket, sq_hash_mask, sq_index);
+
+   // Replay stalled loads that this store's address may unblock.
+   wake_waiters(sq_waiters[sq_index]);
+   wake_matching_loads(sq_index, lq_index, lq_index_phase);
 
    // Attempt to translate the store address. Catch store exceptions.
    try {
@@ -329,7 +569,7 @@ void lsu::store_addr(cycle_t cycle,
       unsigned int al_index = proc->PAY.buf[SQ[sq_index].pay_index].AL_index;
       assert((t.cause() == CAUSE_FAULT_STORE) || (t.cause() == CAUSE_MISALIGNED_STORE));
       proc->set_exception(al_index);
-      proc->PAY.buf[SQ[sq_index].pay_index].trap.post(t);
+      proc->PAY.cold(SQ[sq_index].pay_index).trap.post(t);
 
       return;
    }
@@ -351,6 +591,7 @@ void lsu::store_addr(cycle_t cycle,
 
       if (!hit) inc_counter(spec_store_miss_count);
       if (SQ[sq_index].miss_resolve_cycle == -1) inc_counter(store_mhsr_miss_count);
+      else wake_waiters(mhsr_waiters);
    }
 
 #ifdef RISCV_MICRO_DEBUG
@@ -365,6 +606,9 @@ void lsu::store_value(unsigned int sq_index, reg_t value) {
 
 	SQ[sq_index].value_avail = true;
 	SQ[sq_index].value = value;
+
+	// Replay stalled loads waiting for this store's value.
+	wake_waiters(sq_waiters[sq_index]);
 }
 
 
@@ -377,8 +621,11 @@ bool lsu::load_addr(cycle_t cycle,
 	assert(LQ[lq_index].valid);
 
 	// Set up information for executing the load.
+	if (LQ[lq_index].indexed)
+		index_remove(LQ, lq_bucket, lq_hash_mask, lq_index);
 	LQ[lq_index].addr_avail = true;
 	LQ[lq_index].addr = addr;
+	index_insert(LQ, lq_bucket, lq_hash_mask, lq_index);
 	//LQ[lq_index].back_data = back_data;
 
   #ifdef RISCV_MICRO_DEBUG
@@ -396,11 +643,16 @@ bool lsu::load_addr(cycle_t cycle,
     if(LQ[lq_index].miss_resolve_cycle == -1){
       inc_counter(load_mhsr_miss_count);
     }
+    else {
+      wake_waiters(mhsr_waiters);
+    }
 
 	}
 
 	// Run the load through the load execution datapath.
 	execute_load(cycle, lq_index, lq_index_phase, sq_index, sq_index_phase);
+	if (!LQ[lq_index].value_avail)
+		park_load(cycle, lq_index);
 
 	// Result of running the load through the load execution datapath.
 	value = LQ[lq_index].value;
@@ -408,33 +660,82 @@ bool lsu::load_addr(cycle_t cycle,
 }
 
 bool lsu::load_unstall(cycle_t cycle, unsigned int& pay_index, reg_t& value) {
-   unsigned int scan = lq_head;
-   bool scan_phase = lq_head_phase;
+   unsigned int scan;
+   bool scan_phase;
+   unsigned int from;
+   bool wrapped;
+   int ready;
    bool unstalled = false;
-   while (!((scan == lq_tail) && (scan_phase == lq_tail_phase)) && !unstalled) {
-      assert(LQ[scan].valid);
-      if (LQ[scan].addr_avail && !LQ[scan].value_avail) {
-         // If this load did not get an MHSR during initial execution, access the D$ again.
-         if (!PERFECT_DCACHE && (LQ[scan].miss_resolve_cycle == -1)) {
-            bool hit;
-            assert(LQ[scan].addr_avail);
-            LQ[scan].miss_resolve_cycle = DC->Access(Tid, cycle, LQ[scan].addr, false, &hit);
-            LQ[scan].missed = !hit;
-         }
 
-         // Check if load is unstalled.
-         execute_load(cycle, scan, scan_phase, LQ[scan].sq_index, LQ[scan].sq_index_phase);
-         unstalled = LQ[scan].value_avail;
-         pay_index = LQ[scan].pay_index;
-         value = LQ[scan].value;
+   // Wake the loads whose timers expired.
+   while (!load_timers.empty() && (load_timers.top().cycle <= cycle)) {
+      load_timer_t t = load_timers.top();
+      load_timers.pop();
+      if (LQ[t.lq_index].valid && (LQ[t.lq_index].wait_gen == t.gen))
+         wake_load(t.lq_index);
+   }
+
+   // Replay woken loads in LQ order, from the head, until one unstalls.
+   from = lq_head;
+   wrapped = false;
+   while ((lq_ready > 0) && !unstalled) {
+      ready = lowest_set_bit(lq_ready_bits, from, (wrapped ? lq_head : lq_size));
+      if (ready == -1) {
+         if (wrapped)
+            break;
+         wrapped = true;
+         from = 0;
+         continue;
       }
-      scan = MOD_S((scan + 1), lq_size);
-      if (scan == 0) // wrap-around, i.e., phase change
-         scan_phase = !scan_phase;
+      scan = (unsigned int)ready;
+      scan_phase = (wrapped ? !lq_head_phase : lq_head_phase);
+      CLEAR_BIT(lq_ready_bits[scan >> 6], (scan & 63));
+      lq_ready--;
+      n_replay++;
+
+      assert(LQ[scan].valid);
+      assert(LQ[scan].addr_avail && !LQ[scan].value_avail);
+
+      // If this load did not get an MHSR during initial execution, access the D$ again.
+      if (!PERFECT_DCACHE && (LQ[scan].miss_resolve_cycle == -1)) {
+         bool hit;
+         LQ[scan].miss_resolve_cycle = DC->Access(Tid, cycle, LQ[scan].addr, false, &hit);
+         LQ[scan].missed = !hit;
+         if (LQ[scan].miss_resolve_cycle != -1)
+            wake_waiters(mhsr_waiters);
+      }
+
+      // Check if load is unstalled.
+      execute_load(cycle, scan, scan_phase, LQ[scan].sq_index, LQ[scan].sq_index_phase);
+      unstalled = LQ[scan].value_avail;
+      pay_index = LQ[scan].pay_index;
+      value = LQ[scan].value;
+      if (!unstalled)
+         park_load(cycle, scan);
+
+      from = (scan + 1);
    }
    return(unstalled);
 }
 
+// Returns the earliest cycle, at or after 'cycle', in which a stalled load can unstall by itself,
+// i.e., without any other change to the LSU: its cache miss resolves, or the D$ frees
+// an MHSR for a load that was refused one.  Returns (cycle_t)-1 if there is no such cycle.
+// Also counts the stalled loads and, among them, the loads waiting for an MHSR.
+cycle_t lsu::next_event(cycle_t cycle) {
+   cycle_t event = (cycle_t)-1;
+
+   // Every stalled load that a timer can unstall (miss resolves, or an MHSR frees up) has a timer.
+   // Stale timers (the load was woken since) can only make the event earlier.
+   if (!load_timers.empty())
+      event = load_timers.top().cycle;
+
+   // Loads woken but not yet replayed (replay bandwidth) are replayed next cycle.
+   if (lq_ready > 0)
+      event = cycle;
+   return(event);
+}
+
 void lsu::execute_load(cycle_t cycle,
                        unsigned int lq_index, bool lq_index_phase,
                        unsigned int sq_index, bool sq_index_phase) {
@@ -454,6 +755,7 @@ void lsu::execute_load(cycle_t cycle,
            }
            else {
 	      // Load reservation has not yet reached the head of the LQ and must stall.
+	      LQ[lq_index].wait = LOAD_WAIT_HEAD;
 	      return;
 	   }
         }
@@ -468,6 +770,9 @@ void lsu::execute_load(cycle_t cycle,
   #endif
 
 	if (stall_disambig) {
+		LQ[lq_index].wait = LOAD_WAIT_STORE;
+		LQ[lq_index].wait_store = store_entry;
+
 		// STATS
 		LQ[lq_index].stat_load_stall_disambig = true;
 	}
@@ -575,13 +880,15 @@ void lsu::execute_load(cycle_t cycle,
 
       assert(t.cause() == CAUSE_FAULT_LOAD || t.cause() == CAUSE_MISALIGNED_LOAD);
       proc->set_exception(al_index);
-      proc->PAY.buf[LQ[lq_index].pay_index].trap.post(t);
+      proc->PAY.cold(LQ[lq_index].pay_index).trap.post(t);
 	  }
 
 		// The load value is now available.
 		LQ[lq_index].value_avail = true;
 	}
 	else {
+		LQ[lq_index].wait = LOAD_WAIT_MISS;
+
 		// STATS
 		LQ[lq_index].stat_load_stall_miss = true;
 	}
@@ -626,6 +933,18 @@ void lsu::restore(unsigned int recover_lq_tail, bool recover_lq_tail_phase,
 		LQ[j].valid = true;
 	}
 
+	// Remove squashed loads from the address index and the loads to be replayed.
+	for (unsigned int i = 0; i < lq_size; i++) {
+		if (!LQ[i].valid) {
+			if (LQ[i].indexed)
+				index_remove(LQ, lq_bucket, lq_hash_mask, i);
+			if (BIT_IS_ONE(lq_ready_bits[i >> 6], (i & 63))) {
+				CLEAR_BIT(lq_ready_bits[i >> 6], (i & 63));
+				lq_ready--;
+			}
+		}
+	}
+
 	/////////////////////////////
 	// Restore SQ.
 	/////////////////////////////
@@ -651,6 +970,15 @@ void lsu::restore(unsigned int recover_lq_tail, bool recover_lq_tail_phase,
 	for (unsigned int i = 0, j = sq_head; i < sq_length; i++, j = MOD_S((j+1), sq_size)) {
 		SQ[j].valid = true;
 	}
+
+	// Remove squashed stores from the address index and the unknown-address stores.
+	for (unsigned int i = 0; i < sq_size; i++) {
+		if (!SQ[i].valid) {
+			if (SQ[i].indexed)
+				index_remove(SQ, sq_bucket, sq_hash_mask, i);
+			set_sq_unknown(i, false);
+		}
+	}
 }
 
 void lsu::train(bool load) {
@@ -709,6 +1037,8 @@ bool lsu::commit(bool load, bool atomic_op) {
 
       // Invalidate the entry.
       LQ[lq_head].valid = false;
+      if (LQ[lq_head].indexed)
+         index_remove(LQ, lq_bucket, lq_hash_mask, lq_head);
 
       // Advance the head pointer and decrement the queue length.
       lq_head = MOD_S((lq_head + 1), lq_size);
@@ -718,6 +1048,10 @@ bool lsu::commit(bool load, bool atomic_op) {
       if (lq_head == 0) {
          lq_head_phase = !lq_head_phase;
       }
+
+      // A load reservation stalled until it reaches the head of the LQ may now proceed.
+      if ((lq_length > 0) && LQ[lq_head].addr_avail && !LQ[lq_head].value_avail && (LQ[lq_head].wait == LOAD_WAIT_HEAD))
+         wake_load(lq_head);
    }
    else {
       // SQ should not be empty.
@@ -761,8 +1095,14 @@ bool lsu::commit(bool load, bool atomic_op) {
 	 }
       }
 
+      // Replay stalled loads waiting for this store to commit.
+      wake_waiters(sq_waiters[sq_head]);
+
       // Invalidate the entry.
       SQ[sq_head].valid = false;
+      if (SQ[sq_head].indexed)
+         index_remove(SQ, sq_bucket, sq_hash_mask, sq_head);
+      set_sq_unknown(sq_head, false);
   
       // Advance the head pointer and decrement the queue length.
       sq_head = MOD_S((sq_head + 1), sq_size);
@@ -788,6 +1128,10 @@ void lsu::flush() {
 
 	for (unsigned int i = 0; i < lq_size; i++) {
 		LQ[i].valid = false;
+		LQ[i].indexed = false;
+	}
+	for (unsigned int i = 0; i <= lq_hash_mask; i++) {
+		lq_bucket[i] = -1;
 	}
 
 	// Flush SQ.
@@ -799,7 +1143,27 @@ void lsu::flush() {
 
 	for (unsigned int i = 0; i < sq_size; i++) {
 		SQ[i].valid = false;
+		SQ[i].indexed = false;
+	}
+	for (unsigned int i = 0; i <= sq_hash_mask; i++) {
+		sq_bucket[i] = -1;
+	}
+
+	sq_unknown = 0;
+	for (unsigned int i = 0; i < ((sq_size + 63) >> 6); i++) {
+		sq_unknown_bits[i] = 0;
+	}
+
+	// Flush load replay state.
+	lq_ready = 0;
+	for (unsigned int i = 0; i < ((lq_size + 63) >> 6); i++) {
+		lq_ready_bits[i] = 0;
+	}
+	for (unsigned int i = 0; i < sq_size; i++) {
+		sq_waiters[i].clear();
 	}
+	mhsr_waiters.clear();
+	load_timers = std::priority_queue<load_timer_t, std::vector<load_timer_t>, load_timer_later>();
 }
 
 
@@ -866,6 +1230,67 @@ void lsu::dump_stats(FILE* fp) {
 }
 
 
+// The heap underlying a priority_queue, so that load_timers is saved and restored exactly,
+// i.e., timers with equal cycles are popped in the same order after a resume.
+template <class PQ>
+static typename PQ::container_type& pq_container(PQ& q) {
+	struct access : PQ {
+		static typename PQ::container_type& get(PQ& q) { return(q.*(&access::c)); }
+	};
+	return(access::get(q));
+}
+
+void lsu::snapshot(snapshot_t& s) {
+	s.check(lq_size, "LQ size");
+	s.check(sq_size, "SQ size");
+
+	s.io(LQ, lq_size);
+	s.io(lq_head);
+	s.io(lq_tail);
+	s.io(lq_length);
+	s.io(lq_head_phase);
+	s.io(lq_tail_phase);
+
+	s.io(SQ, sq_size);
+	s.io(sq_head);
+	s.io(sq_tail);
+	s.io(sq_length);
+	s.io(sq_head_phase);
+	s.io(sq_tail_phase);
+
+	s.io(lq_bucket, lq_hash_mask + 1);
+	s.io(sq_bucket, sq_hash_mask + 1);
+	s.io(sq_unknown);
+	s.io(sq_unknown_bits, (sq_size + 63) >> 6);
+
+	s.io(lq_ready_bits, (lq_size + 63) >> 6);
+	s.io(lq_ready);
+	for (unsigned int i = 0; i < sq_size; i++)
+		s.io(sq_waiters[i]);
+	s.io(mhsr_waiters);
+	s.io(pq_container(load_timers));
+	s.io(n_replay);
+
+	s.io(MDP);
+
+	measurements(s);
+
+	DC->snapshot(s);
+}
+
+void lsu::measurements(snapshot_t& s) {
+	s.io(n_stall_disambig);
+	s.io(n_forward);
+	s.io(n_stall_miss_l);
+	s.io(n_stall_miss_s);
+	s.io(n_load);
+	s.io(n_store);
+	s.io(n_true_stall);
+	s.io(n_false_stall);
+	s.io(n_load_violation);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////
 
 
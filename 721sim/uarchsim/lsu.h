@@ -8,6 +8,13 @@
 ///////////////////////////////////////////////////////////////
 //#include "CcacheClass.h"
 
+// What a stalled load is waiting for (see execute_load()).
+typedef enum {
+  LOAD_WAIT_HEAD,   // load reservation must reach the LQ head
+  LOAD_WAIT_STORE,  // disambiguation: a prior store's address, value, or commit
+  LOAD_WAIT_MISS    // the load's cache miss must resolve
+} load_wait_t;
+
 // Single entry in the load-store queue.
 typedef struct {
   bool valid;   // this entry holds an active load or store
@@ -38,6 +45,17 @@ typedef struct {
   // and a prediction from the memory dependence predictor (MDP).
   bool mdp_stall;
 
+  // Load replay: what the stalled load is waiting for, and (LOAD_WAIT_STORE) the store's SQ index.
+  load_wait_t wait;
+  unsigned int wait_store;
+  // Load replay: incremented whenever the stalled load is parked or woken, invalidating its older wait list entries.
+  uint64_t wait_gen;
+
+  // Address index: entry is linked into its queue's hash table (see below).
+  bool indexed;
+  int hash_prev;
+  int hash_next;
+
   // STATS
   bool stat_load_stall_disambig;  // Load stalled due to an unknown store address, an unavailable store value, or a different store value size.
   bool stat_load_stall_disambig_addrunknown; // Load stalled due to an unknown store address.
@@ -48,12 +66,30 @@ typedef struct {
   bool stat_late_store_match;	// A stalled load observed an address match with a late-arriving older store.
 } lsq_entry;
 
+// Wait list entry: a parked load, valid only while the load's wait_gen still matches.
+typedef struct {
+  unsigned int lq_index;
+  uint64_t gen;
+} load_waiter_t;
+
+// Timed wait list entry: wake the parked load at 'cycle'.
+typedef struct {
+  cycle_t cycle;
+  unsigned int lq_index;
+  uint64_t gen;
+} load_timer_t;
+
+struct load_timer_later {
+  bool operator()(const load_timer_t& a, const load_timer_t& b) const { return(a.cycle > b.cycle); }
+};
+
 
 //Forward declaring classes 
 class mmu_t;
 class pipeline_t;
 class CacheClass;
 class stats_t;
+class snapshot_t;
 
 class lsu {
 
@@ -88,6 +124,39 @@ private:
   bool sq_head_phase;
   bool sq_tail_phase;
 
+  //////////////////////////
+  // Address index
+  //////////////////////////
+  // Loads and stores whose addresses are known are hashed by 8-byte granule, i.e., the largest access size,
+  // so that two accesses can only conflict if they are in the same hash chain.
+  // This lets disambiguate() and ld_violation() examine only potentially conflicting entries instead of walking the queues.
+  int* lq_bucket;            // head of each LQ hash chain (-1: empty)
+  unsigned int lq_hash_mask; // number of LQ hash chains minus 1
+  int* sq_bucket;            // head of each SQ hash chain (-1: empty)
+  unsigned int sq_hash_mask; // number of SQ hash chains minus 1
+
+  // Stores whose addresses are not yet known: running count and bit vector indexed by SQ index.
+  unsigned int sq_unknown;
+  uint64_t* sq_unknown_bits;
+
+  //////////////////////////
+  // Load replay
+  //////////////////////////
+  // A stalled load is parked on the wait lists of whatever blocks it, and is replayed (re-executed)
+  // only after it is woken by a change to one of them:
+  // - sq_waiters: a prior store gets its address or value, or commits;
+  //   also, a prior store whose address arrives and matches wakes the stalled load directly (via the address index)
+  // - load_timers: the load's cache miss resolves, or the D$ may free an MHSR for a load that was refused one
+  // - mhsr_waiters: any D$ access, which may free an MHSR or bring in the line, for a load that was refused an MHSR
+  // - a load reservation reaches the LQ head
+  // Woken loads are replayed oldest first, and load_unstall() stops at the first one that unstalls.
+  uint64_t* lq_ready_bits;    // woken loads, by LQ index
+  unsigned int lq_ready;      // number of woken loads
+  std::vector<load_waiter_t>* sq_waiters;
+  std::vector<load_waiter_t> mhsr_waiters;
+  std::priority_queue<load_timer_t, std::vector<load_timer_t>, load_timer_later> load_timers;
+  uint64_t n_replay;          // number of load replays so far (a replayed load changes the LSU, even if it stays stalled)
+
   //////////////////////////
   // Data Cache
   //////////////////////////
@@ -155,6 +224,20 @@ private:
                     unsigned int lq_index, bool lq_index_phase,
                     unsigned int& load_entry);
 
+  // Address index maintenance.
+  void index_insert(lsq_entry* Q, int* bucket, unsigned int hash_mask, unsigned int entry);
+  void index_remove(lsq_entry* Q, int* bucket, unsigned int hash_mask, unsigned int entry);
+  void set_sq_unknown(unsigned int entry, bool unknown);
+
+  // Load replay.
+  void park_load(cycle_t cycle, unsigned int lq_index);
+  void wake_load(unsigned int lq_index);
+  void wake_waiters(std::vector<load_waiter_t>& waiters);
+  void wake_matching_loads(unsigned int sq_index, unsigned int lq_index, bool lq_index_phase);
+
+  // Youngest store with an unknown address among the stores prior to a load (-1 if none).
+  int youngest_unknown_store(unsigned int sq_index);
+
   // Allocate a chunk of memory.
   char* mem_newblock(void);
 
@@ -203,8 +286,21 @@ public:
   void set_stats(stats_t* _stats){this->stats = _stats;}
   void dump_stats(FILE* fp);
 
+  // Idle-cycle fast-forward support.
+  unsigned int get_lq_length() { return lq_length; }
+  unsigned int get_sq_length() { return sq_length; }
+  uint64_t get_replays() { return n_replay; }
+  cycle_t next_event(cycle_t cycle);	// earliest cycle in which a load replay timer fires ((cycle_t)-1 if none)
+  CacheClass* get_dc() { return DC; }
+
   void dump_lq(pipeline_t* proc, unsigned int index,FILE* file=stderr);
   void dump_sq(pipeline_t* proc, unsigned int index,FILE* file=stderr);
+
+  // Save or restore the LQ/SQ, the address index, the load replay wait lists, the MDP, and the D$.
+  void snapshot(snapshot_t& s);
+
+  // Save or restore the measurements only (the counters in dump_stats()).
+  void measurements(snapshot_t& s);
 };
 
 #endif //LSU_H
@@ -8,6 +8,7 @@
 #include <fesvr/option_parser.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <getopt.h>
 #include <vector>
 #include <string>
@@ -15,15 +16,27 @@
 #include <algorithm>
 #include "debug.h"
 #include "parameters.h"
+#include "stats.h"
 #include <signal.h>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <thread>
+#include <unistd.h>
+#include <fcntl.h>
+#include <climits>
+#include <cstring>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
 
 static void help()
 {
   fprintf(stderr, "usage: micros [host options] <target program> [target options]\n");
   fprintf(stderr, "Host Options:\n");
-  fprintf(stderr, "  -c<gz_chkpt_file>  Start simulation from a .gz checkpoint file.\n");
+  fprintf(stderr, "  -c<chkpt_file>     Start simulation from a checkpoint file (or a legacy .gz checkpoint).\n");
   fprintf(stderr, "  -d                 Interactive debug mode\n");
-  fprintf(stderr, "  -e<n>              End simulation after <n> instructions have been committed by microarchitectural simulation\n");
+  fprintf(stderr, "  -e<n>              End simulation after <n> instructions have been committed by microarchitectural simulation (with --sample, including warmup instructions)\n");
   fprintf(stderr, "  -g                 Track histogram of PCs\n");
   fprintf(stderr, "  -h                 Print this help message\n");
   fprintf(stderr, "  -l<n>              Enable logging after <n> commits if compiled with support\n");
@@ -57,7 +70,23 @@ static void help()
   fprintf(stderr, "  --dw=<n>           <n> wide dispatch\n");
   fprintf(stderr, "  --iw=<n>           <n> wide issue / <n> execution lanes\n");
   fprintf(stderr, "  --rw=<n>           <n> wide retire\n");
+  fprintf(stderr, "  --lrw=<n>          Up to <n> stalled loads can unstall (load replay) per cycle\n");
   fprintf(stderr, "  --phase=<n>        Phase interval is <n>\n");
+  fprintf(stderr, "  --simpoint=<interval>[:<max_k>]\tInstead of simulating, run the whole program in fast-skip mode profiling basic block vectors every <interval> instructions, and pick at most <max_k> (default: 10) simulation points. Writes simpoint.bb.gz, simpoint.simpoints and simpoint.weights.\n");
+  fprintf(stderr, "  --sample=<period>[:<unit>[:<warmup>[:<error>]]]\tSample the timing simulation, SMARTS-style: of every <period> instructions, simulate <warmup> (default: 2000) instructions in detail to warm up, measure the CPI of the next <unit> (default: 1000) instructions, and fast-skip the rest. Stops once the mean CPI is within <error> (default: 0.03) at 99.7%% confidence. The per-unit CPIs and the estimate go to stats.log.\n");
+  fprintf(stderr, "  --warm=<0|1>       Functional warming (default: 0): while fast skipping (-s, --sample), train the timing simulator's caches and branch predictors with each instruction fetch, branch outcome, and load/store address. No stats are collected.\n");
+  fprintf(stderr, "  --livestats=<n>    Every <n> cycles (default: 0, never), update the live statistics region live.<proc>.stats, which monitoring tools can map and read while the simulation runs (layout: live_stats_t in stats.h). Sending SIGUSR1 updates it immediately and writes the same snapshot (cycle, instructions, IPC, counters) as text to live.<proc>.log.\n");
+  fprintf(stderr, "  --idleff=<0|1>     Fast-forward over idle cycles, e.g., long cache misses (default: 1). Stats are identical either way.\n");
+  fprintf(stderr, "  --fastiq=<0|1>     Issue queue wakeup/select via consumer lists and a ready bitset (1) or via full scans (0) (default: 1). Stats are identical either way.\n");
+  fprintf(stderr, "  --no-checker       Don't check retired instructions against the ISA simulator, and don't instantiate it. Not compatible with perfect branch prediction or oracle disambiguation, which take their oracle from the ISA simulator.\n");
+  fprintf(stderr, "  --isathread=<n>    Run the ISA checker simulator ahead on its own host thread: 0 (never), 1 (if the host has more than one CPU), 2 (always) (default: 1). Stats are identical either way.\n");
+  fprintf(stderr, "  --hugepage         Back target memory with transparent huge pages. Faster for dense memory footprints, but commits host memory 2MB at a time.\n");
+  fprintf(stderr, "  --sweep=<file>[:<jobs>]\tConfiguration sweep: skip (-s) or restore (-c) once, then fork one timing simulation per line of <file>, \"<name> [<option> ...]\", at most <jobs> (default: one per host CPU) at a time. Each runs with the command line's options plus its own, in directory <name> (stats log, stdout.txt, stderr.txt, and its own copy of each file the target had open for writing). Options that shape the skip or restore (-s, -c, -m, -p, --no-checker, ...) only take effect on the command line.\n");
+  fprintf(stderr, "  --snapshot=<dir>:<cycles>\tEvery <cycles> cycles of timing simulation, replace the timing snapshot <dir>: checkpoints of the target and the complete microarchitectural state (pipeline, predictors, caches, stats), from which --resume continues cycle for cycle. Not with --sample or --sweep.\n");
+  fprintf(stderr, "  --resume=<dir>     Resume the timing simulation from the timing snapshot <dir>, instead of skipping (-s) or restoring (-c). The timing configuration and the checker options (--no-checker, --isathread) must be the ones the snapshot was taken with.\n");
+  fprintf(stderr, "  --chkptz=<0|1>     Compress the pages of created checkpoints, in independent 1MB blocks (default: 0). Uncompressed checkpoints restore fastest from local disk.\n");
+  fprintf(stderr, "  --chkptthreads=<n> Compress/decompress checkpoint blocks on <n> threads (default: 0, one per host CPU).\n");
+  fprintf(stderr, "  --chkpts=<n>[,<n>...] | --chkpts=<simpoints_file>:<interval>\tInstead of simulating, run the program in fast-skip mode once, writing checkpoint chkpt.<n> after each <n> instructions (or at the start of each simulation point of a simpoint.simpoints file). Checkpoints are written on a background thread while skipping continues.\n");
   fprintf(stderr, "  --lane=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\tEach of <X> is a bit vector indicating which lanes support that instruction type.\n");
   fprintf(stderr, "  --lat=<B>:<L>:<S>:<C>:<LFP>:<FP>:<MTF>\tEach of <X> is an unsigned integer indicating the latency of that instruction type.\n");
   fprintf(stderr, "  -u                 Shortcut to configure universal lanes. Equivalent to: --lane=0xffff:0xffff:0xffff:0xffff:0xffff:0xffff:0xffff --lat=1:1:1:1:1:1:1\n");
@@ -67,6 +96,8 @@ static void help()
   fprintf(stderr, "  --L2=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>\tConfigure L2 $. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
   fprintf(stderr, "  --L3=<SIZE>:<ASSOC>:<BLOCKSIZE>:<#MHSR>:<HITTIME>\tConfigure L3 $. Derived # sets must be power-of-2. Block size must be power-of-2.\n");
   fprintf(stderr, "  --MEMLAT=<latency>\tConfigure a fixed miss penalty for a miss in the LLC.\n");
+  fprintf(stderr, "  +syscall-record=<file>  Record the effects of the target's syscalls (memory writes, results, output) in a binary log.\n");
+  fprintf(stderr, "  +syscall-replay=<file>  Serve the target's syscalls from a log recorded by +syscall-record, without running them on the host.\n");
   exit(1);
 }
 
@@ -152,6 +183,107 @@ static void set_perfect_flags(const char* config) {
    }
 }
 
+static void set_simpoint(const char* config) {
+   uint64_t interval;
+   unsigned int max_k = SIMPOINT_MAX_K;
+   if ((sscanf(config, "%lu:%u", &interval, &max_k) < 1) || !interval || !max_k) {
+      fprintf(stderr, "Incorrect usage:\n");
+      fprintf(stderr, "--simpoint=<interval>[:<max_k>]\tProfile basic block vectors every <interval> instructions, and pick at most <max_k> simulation points.\n");
+      exit(-1);
+   }
+   SIMPOINT_INTERVAL = interval;
+   SIMPOINT_MAX_K = max_k;
+}
+
+static void set_checkpoint_points(const char* config, std::vector<uint64_t>& points) {
+   const char* colon = strrchr(config, ':');
+   bool ok = true;
+   if (colon) {
+      // SimPoint output: "<interval> <cluster>" lines.
+      uint64_t interval = 0;
+      std::string file(config, colon - config);
+      FILE* fp = fopen(file.c_str(), "r");
+      ok = fp && (sscanf(colon + 1, "%lu", &interval) == 1) && interval;
+      uint64_t point, cluster;
+      while (ok && (fscanf(fp, "%lu %lu", &point, &cluster) == 2))
+         points.push_back(point * interval);
+      if (fp)
+         fclose(fp);
+   }
+   else {
+      for (const char* s = config; ok && *s; ) {
+         char* end;
+         points.push_back(strtoull(s, &end, 0));
+         ok = (end != s) && ((*end == ',') || !*end);
+         s = (*end ? end + 1 : end);
+      }
+   }
+   if (!ok || points.empty()) {
+      fprintf(stderr, "Incorrect usage:\n");
+      fprintf(stderr, "--chkpts=<n>[,<n>...] | --chkpts=<simpoints_file>:<interval>\tWrite a checkpoint after each <n> instructions, or at the start of each simulation point.\n");
+      exit(-1);
+   }
+   std::sort(points.begin(), points.end());
+   points.erase(std::unique(points.begin(), points.end()), points.end());
+}
+
+static void set_sample(const char* config) {
+   uint64_t period;
+   uint64_t unit = SAMPLE_UNIT;
+   uint64_t warmup = SAMPLE_WARMUP;
+   double error = SAMPLE_ERROR;
+   if ((sscanf(config, "%lu:%lu:%lu:%lf", &period, &unit, &warmup, &error) < 1) || !period || !unit || (error < 0)) {
+      fprintf(stderr, "Incorrect usage:\n");
+      fprintf(stderr, "--sample=<period>[:<unit>[:<warmup>[:<error>]]]\tOf every <period> instructions, warm up for <warmup> instructions and measure <unit> instructions in detail, until the CPI is within relative <error>.\n");
+      exit(-1);
+   }
+   SAMPLE_PERIOD = period;
+   SAMPLE_UNIT = unit;
+   SAMPLE_WARMUP = warmup;
+   SAMPLE_ERROR = error;
+}
+
+// A configuration of a sweep: its name (and directory), and its options.
+struct sweep_point_t {
+   std::string name;
+   std::vector<std::string> options;
+};
+
+static void set_sweep(const char* config, std::vector<sweep_point_t>& points) {
+   const char* colon = strrchr(config, ':');
+   std::string file(config, (colon ? (size_t)(colon - config) : strlen(config)));
+   bool ok = (!colon || (sscanf(colon + 1, "%u", &SWEEP_JOBS) == 1));
+   std::ifstream in(file.c_str());
+   ok = ok && in;
+   std::string line;
+   while (ok && std::getline(in, line)) {
+      std::istringstream words(line.substr(0, line.find('#')));
+      sweep_point_t point;
+      if (!(words >> point.name))
+         continue;
+      for (std::string option; words >> option; )
+         point.options.push_back(option);
+      for (size_t i = 0; i < points.size(); i++)
+         ok = ok && (points[i].name != point.name);
+      points.push_back(point);
+   }
+   if (!ok || points.empty()) {
+      fprintf(stderr, "Incorrect usage:\n");
+      fprintf(stderr, "--sweep=<file>[:<jobs>]\tSimulate each configuration \"<name> [<option> ...]\" (one per line, distinct names) of <file> after one skip or restore, at most <jobs> at a time.\n");
+      exit(-1);
+   }
+}
+
+static void set_snapshot(const char* config, std::string& dir, uint64_t& interval) {
+   const char* colon = strrchr(config, ':');
+   if (!colon || (colon == config) || (sscanf(colon + 1, "%lu", &interval) != 1) || !interval) {
+      fprintf(stderr, "Incorrect usage:\n");
+      fprintf(stderr, "--snapshot=<dir>:<cycles>\tWrite a timing snapshot to directory <dir> every <cycles> cycles.\n");
+      exit(-1);
+   }
+   dir.assign(config, colon - config);
+}
+
 static void set_disambig_flags(const char* config) {
    uint64_t mdp_model, mdp_ctr_max;
    if (sscanf(config, "%lu,%lu", &mdp_model, &mdp_ctr_max) != 2) {
@@ -322,13 +454,210 @@ debug_buffer_t* DB;
 sim_t*  s_isa;
 sim_t*  s_micro;
 
+// A regular host file the target has open at the sweep's fork point
+// (including stdin/stdout redirected from/to a file), and its offset there.
+struct sweep_file_t {
+   int fd;		// host fd
+   int target_fd;
+   int flags;
+   off_t offset;
+   std::string path;
+};
+
+// Only the target's files: the simulator's own (stats log, checkpoints,
+// ...) are replaced or left alone by each child.
+static std::vector<sweep_file_t> find_sweep_files(sim_t* owner) {
+   std::vector<sweep_file_t> files;
+   const std::vector<int>& fds = owner->get_htif()->target_fds();
+   for (size_t i = 0; i < fds.size(); i++) {
+      struct stat st;
+      char path[PATH_MAX];
+      std::string link = "/proc/self/fd/" + std::to_string(fds[i]);
+      ssize_t len = readlink(link.c_str(), path, sizeof(path) - 1);
+      if ((fds[i] < 0) || fstat(fds[i], &st) || !S_ISREG(st.st_mode) || (len < 0))
+         continue;
+      path[len] = '\0';
+      sweep_file_t file = {fds[i], (int)i, fcntl(fds[i], F_GETFL), lseek(fds[i], 0, SEEK_CUR), path};
+      files.push_back(file);
+   }
+   return files;
+}
+
+static bool sweep_file_written(const sweep_file_t& file) {
+   return ((file.flags & O_ACCMODE) != O_RDONLY);
+}
+
+// Reopens the files read at their offsets at the fork point, so that the
+// next child does not share file offsets with the children already running.
+// (Files written are redirected by each child, see redirect_sweep_files().)
+static void unshare_sweep_files(const std::vector<sweep_file_t>& files) {
+   for (size_t i = 0; i < files.size(); i++) {
+      if (sweep_file_written(files[i]))
+         continue;
+      std::string path = "/proc/self/fd/" + std::to_string(files[i].fd);
+      int fd = open(path.c_str(), files[i].flags & ~(O_CREAT | O_EXCL | O_TRUNC));
+      if (fd < 0)
+         continue;
+      lseek(fd, files[i].offset, SEEK_SET);
+      dup2(fd, files[i].fd);
+      close(fd);
+   }
+}
+
+static void redirect_output(int to, const char* file) {
+   int fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if ((fd < 0) || (dup2(fd, to) < 0)) {
+      perror(file);
+      exit(-1);
+   }
+   close(fd);
+}
+
+static void sweep_file_error(const std::string& file) {
+   fprintf(stderr, "Sweep: redirecting the target's file %s failed (%s).\n", file.c_str(), strerror(errno));
+   exit(-1);
+}
+
+// Gives a sweep child its own copy, in its directory, of each file the
+// target writes, so that the children don't write over one another. The
+// copy starts out with the file's contents at the fork point. The target's
+// stdout and stderr go to the child's stdout.txt and stderr.txt instead.
+static void redirect_sweep_files(const std::vector<sweep_file_t>& files, const sweep_point_t& point) {
+   std::map<std::string, int> names;
+   for (size_t i = 0; i < files.size(); i++) {
+      const sweep_file_t& file = files[i];
+      if (!sweep_file_written(file))
+         continue;
+      if ((file.target_fd == STDOUT_FILENO) || (file.target_fd == STDERR_FILENO)) {
+         if (dup2(file.target_fd, file.fd) < 0)
+            sweep_file_error(file.path);
+         continue;
+      }
+
+      std::string name = file.path.substr(file.path.find_last_of('/') + 1);
+      if (names[name]++ || (name == "stdout.txt") || (name == "stderr.txt"))
+         name += "." + std::to_string(file.target_fd);
+      // The target may hold the file write-only: read it through a new read-only open.
+      int original = open(("/proc/self/fd/" + std::to_string(file.fd)).c_str(), O_RDONLY);
+      int copy = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if ((original < 0) || (copy < 0))
+         sweep_file_error(file.path);
+      char buf[65536];
+      ssize_t n;
+      while ((n = read(original, buf, sizeof(buf))) != 0)
+         if ((n < 0) || (write(copy, buf, n) != n))
+            sweep_file_error(file.path);
+      close(original);
+      close(copy);
+
+      copy = open(name.c_str(), file.flags & ~(O_CREAT | O_EXCL | O_TRUNC));
+      if ((copy < 0) || (lseek(copy, file.offset, SEEK_SET) < 0) || (dup2(copy, file.fd) < 0))
+         sweep_file_error(file.path);
+      close(copy);
+      fprintf(stderr, "Sweep configuration %s: the target's file %s is written to %s/%s\n",
+              point.name.c_str(), file.path.c_str(), point.name.c_str(), name.c_str());
+   }
+}
+
+// Sets up a sweep child for its configuration: in its own directory, with
+// its options applied and the timing simulator rebuilt with them.
+static void start_sweep_point(option_parser_t& parser, const char* argv0, const sweep_point_t& point,
+                              const std::vector<sweep_file_t>& files) {
+   if ((mkdir(point.name.c_str(), 0777) && (errno != EEXIST)) || chdir(point.name.c_str())) {
+      perror(point.name.c_str());
+      exit(-1);
+   }
+   redirect_output(STDOUT_FILENO, "stdout.txt");
+   redirect_output(STDERR_FILENO, "stderr.txt");
+   redirect_sweep_files(files, point);
+
+   std::vector<const char*> args(1, argv0);
+   for (size_t i = 0; i < point.options.size(); i++)
+      args.push_back(point.options[i].c_str());
+   args.push_back(NULL);
+   const char* const* rest = parser.parse(&args[0]);
+   if (*rest) {
+      fprintf(stderr, "Incorrect usage: sweep configuration %s: %s is not an option\n", point.name.c_str(), *rest);
+      exit(-1);
+   }
+   if ((PERFECT_BRANCH_PRED || ORACLE_DISAMBIG) && !s_isa) {
+      fprintf(stderr, "Sweep configuration %s: perfect branch prediction and oracle disambiguation need the ISA simulator (drop --no-checker).\n", point.name.c_str());
+      exit(-1);
+   }
+   fprintf(stderr, "Sweep configuration %s\n", point.name.c_str());
+   s_micro->rebuild_procs();
+}
+
+// Runs a configuration sweep from the current (skipped or restored) state,
+// forking one child per configuration, at most SWEEP_JOBS at a time. Target
+// memory is shared copy-on-write. Returns true in each child, set up with
+// its configuration (options applied, timing simulator rebuilt, in its own
+// directory) to go on and simulate. Returns false in the parent once all
+// children are done, with 'code' 0 if they all exited with 0.
+static bool fork_sweep(option_parser_t& parser, const char* argv0, const std::vector<sweep_point_t>& points, int& code) {
+   size_t jobs = (SWEEP_JOBS ? SWEEP_JOBS : std::max(1u, std::thread::hardware_concurrency()));
+   std::vector<sweep_file_t> files = find_sweep_files(s_isa ? s_isa : s_micro);
+   std::map<pid_t, size_t> running;
+   size_t next = 0;
+
+   fprintf(stderr, "Sweeping %lu configurations, %lu at a time\n", points.size(), jobs);
+   fflush(NULL);	// Buffered output would be written again by each child.
+   code = 0;
+   // After SIGINT/SIGUSR2 (which the children get too), no more children
+   // are started, and the running ones are waited for.
+   while (((next < points.size()) && !end_requested) || !running.empty()) {
+      if ((next < points.size()) && !end_requested && (running.size() < jobs)) {
+         unshare_sweep_files(files);
+         pid_t pid = fork();
+         if (pid < 0) {
+            perror("fork");
+            exit(-1);
+         }
+         if (pid == 0) {
+            start_sweep_point(parser, argv0, points[next], files);
+            return true;
+         }
+         running[pid] = next++;
+      }
+      else {
+         int status;
+         pid_t pid = wait(&status);
+         if (pid < 0) {
+            if (errno == EINTR)
+               continue;
+            perror("wait");
+            exit(-1);
+         }
+         const sweep_point_t& point = points[running[pid]];
+         if (WIFEXITED(status))
+            fprintf(stderr, "Sweep: %s exited with %d\n", point.name.c_str(), WEXITSTATUS(status));
+         else
+            fprintf(stderr, "Sweep: %s was killed by signal %d\n", point.name.c_str(), WTERMSIG(status));
+         if (!WIFEXITED(status) || WEXITSTATUS(status))
+            code = 1;
+         running.erase(pid);
+      }
+   }
+   return false;
+}
+
+// Only counts the request: the timing simulator serves it at the end of its
+// current cycle (see pipeline_t::live_stats()).
+static void requestLiveStats(int signal)
+{
+  live_stats_requests++;
+}
+
+// Only flags the request: the simulators may be stepped by the debug
+// buffer's ISA thread, so they are stopped and deleted (dumping the stats)
+// by main() once the timing simulation returns. A second request, e.g.,
+// during a long fast skip, ends the process at once, without stats.
 static void endSimulation(int signal)
 {
-  //*** Must delete the simulator instances in order to dump stats ***
-  // Stats are dumped in the destructor for the processor instances.
-  delete s_isa;
-  delete s_micro;
-}  
+  if (end_requested)
+    _exit(-1);
+  end_requested = 1;
+}
 
 
 
@@ -346,6 +675,11 @@ int main(int argc, char** argv)
   bool skip_enable = false;   /////////////
 
   std::string checkpoint_file = "";
+  std::vector<uint64_t> checkpoint_points;
+  std::vector<sweep_point_t> sweep_points;
+  std::string snapshot_dir = "";
+  uint64_t snapshot_interval = 0;
+  std::string resume_dir = "";
 
   option_parser_t parser;
   parser.help(&help);
@@ -391,7 +725,23 @@ int main(int argc, char** argv)
   parser.option(0, "dw"  , 1, [&](const char* s){DISPATCH_WIDTH = atoi(s);});
   parser.option(0, "iw"  , 1, [&](const char* s){ISSUE_WIDTH = atoi(s);});
   parser.option(0, "rw"  , 1, [&](const char* s){RETIRE_WIDTH = atoi(s);});
+  parser.option(0, "lrw" , 1, [&](const char* s){LOAD_REPLAY_WIDTH = atoi(s);});
   parser.option(0, "phase",1, [&](const char *s){phase_interval = atoll(s);});
+  parser.option(0, "simpoint",1, [&](const char *s){set_simpoint(s);});
+  parser.option(0, "sample",1, [&](const char *s){set_sample(s);});
+  parser.option(0, "warm",1, [&](const char *s){FUNCTIONAL_WARMING = (atoi(s) ? true : false);});
+  parser.option(0, "livestats",1, [&](const char *s){LIVE_STATS_INTERVAL = atoll(s);});
+  parser.option(0, "idleff",1, [&](const char *s){FAST_FORWARD_IDLE = (atoi(s) ? true : false);});
+  parser.option(0, "fastiq",1, [&](const char *s){FAST_IQ = (atoi(s) ? true : false);});
+  parser.option(0, "no-checker",0, [&](const char *s){CHECKER = false;});
+  parser.option(0, "isathread",1, [&](const char *s){ISA_THREAD = atoi(s);});
+  parser.option(0, "hugepage",0, [&](const char *s){MEM_HUGEPAGE = true;});
+  parser.option(0, "chkptz",1, [&](const char *s){CHECKPOINT_COMPRESS = (atoi(s) ? true : false);});
+  parser.option(0, "chkptthreads",1, [&](const char *s){CHECKPOINT_THREADS = atoi(s);});
+  parser.option(0, "chkpts",1, [&](const char *s){set_checkpoint_points(s, checkpoint_points);});
+  parser.option(0, "sweep",1, [&](const char *s){set_sweep(s, sweep_points);});
+  parser.option(0, "snapshot",1, [&](const char *s){set_snapshot(s, snapshot_dir, snapshot_interval);});
+  parser.option(0, "resume",1, [&](const char *s){resume_dir = s;});
   parser.option(0, "lane" ,1, [&](const char *s){set_lane_matrix(s);});
   parser.option(0, "lat"  ,1, [&](const char *s){set_lane_latencies(s);});
   parser.option('u', 0, 0, [&](const char* s){set_lane_matrix("0xffff:0xffff:0xffff:0xffff:0xffff:0xffff:0xffff"); set_lane_latencies("1:1:1:1:1:1:1");});
@@ -401,8 +751,28 @@ int main(int argc, char** argv)
     help();
   std::vector<std::string> htif_args(argv1, (const char*const*)argv + argc);
 
+  // Timing snapshots capture one continuous timing simulation.
+  bool snapshots = (snapshot_interval || (resume_dir != ""));
+  if (snapshots && (SAMPLE_PERIOD || !sweep_points.empty())) {
+    fprintf(stderr, "Incorrect usage: --snapshot and --resume cannot be combined with --sample or --sweep.\n");
+    exit(-1);
+  }
+  if ((resume_dir != "") && (skip_enable || (checkpoint_file != ""))) {
+    fprintf(stderr, "Incorrect usage: --resume replaces -s and -c.\n");
+    exit(-1);
+  }
+  if (!CHECKER && (PERFECT_BRANCH_PRED || ORACLE_DISAMBIG)) {
+    fprintf(stderr, "Incorrect usage: perfect branch prediction and oracle disambiguation need the ISA simulator, which --no-checker removes.\n");
+    exit(-1);
+  }
+
   #ifdef RISCV_MICRO_CHECKER
-  s_isa = new sim_t(nprocs, mem_mb, htif_args, ISA_SIM);
+  // The ISA sim checks every retired instruction, and is also the oracle
+  // for perfect branch prediction and oracle memory disambiguation.
+  // With --no-checker (which excludes the oracle modes, see above), the
+  // timing simulator runs alone.
+  if (CHECKER)
+    s_isa = new sim_t(nprocs, mem_mb, htif_args, ISA_SIM);
   #endif
 
   s_micro = new sim_t(nprocs, mem_mb, htif_args, MICRO_SIM);
@@ -411,12 +781,15 @@ int main(int argc, char** argv)
   s_micro->set_histogram(histogram);
 
   #ifdef RISCV_MICRO_CHECKER
-    DB = new debug_buffer_t(PIPE_QUEUE_SIZE);
+  if (s_isa) {
+    // A dedicated ISA sim thread only pays off with a second host CPU.
+    DB = new debug_buffer_t(PIPE_QUEUE_SIZE, (ISA_THREAD == 2) || ((ISA_THREAD == 1) && (std::thread::hardware_concurrency() > 1)));
 
     DB->set_isa_sim(s_isa);
 
     s_isa->set_procs_pipe(DB);
     s_micro->set_procs_pipe(DB);
+  }
   #endif
 
   int i, exit_code, exec_index;
@@ -452,7 +825,11 @@ int main(int argc, char** argv)
   sigaction(SIGINT,   &sigIntHandler, NULL);
 
   /* catch SIGUSR1 and dump intermediate stats */
-  sigaction(SIGUSR1,  &sigIntHandler, NULL);
+  struct sigaction sigLiveHandler;
+  sigLiveHandler.sa_handler = requestLiveStats;
+  sigemptyset(&sigLiveHandler.sa_mask);
+  sigLiveHandler.sa_flags = SA_RESTART;
+  sigaction(SIGUSR1,  &sigLiveHandler, NULL);
 
   /* catch SIGUSR1 and dump intermediate stats */
   sigaction(SIGUSR2,  &sigIntHandler, NULL);
@@ -517,10 +894,53 @@ int main(int argc, char** argv)
   if(logging_on_at == -1)
     logging_on = true;
 
+  #ifdef RISCV_ENABLE_SIMPOINT
+  // SimPoint profiling runs the whole program in fast-skip mode, in the
+  // simulator that runs the target's syscalls.
+  if (SIMPOINT_INTERVAL) {
+    sim_t* s_prof = (s_isa ? s_isa : s_micro);
+    s_prof->boot();
+    s_prof->set_simpoint(true, SIMPOINT_INTERVAL);
+    fprintf(stderr, "Profiling basic block vectors every %lu instructions\n", SIMPOINT_INTERVAL);
+    s_prof->run_fast(SIZE_MAX);
+    s_prof->pick_simpoints(SIMPOINT_MAX_K);
+    return 0;
+  }
+  #endif
+
+  // Creating checkpoints likewise runs the program once in fast-skip mode,
+  // checkpointing at each point on the way.
+  if (!checkpoint_points.empty()) {
+    sim_t* s_chkpt = (s_isa ? s_isa : s_micro);
+    s_chkpt->boot();
+    s_chkpt->init_checkpoint("");
+    uint64_t skipped = 0;
+    for (size_t i = 0; i < checkpoint_points.size(); i++) {
+      fprintf(stderr, "Fast skipping to instruction %lu\n", checkpoint_points[i]);
+      if (!s_chkpt->run_fast(checkpoint_points[i] - skipped)) {
+        fprintf(stderr, "Program ended before instruction %lu\n", checkpoint_points[i]);
+        break;
+      }
+      skipped = checkpoint_points[i];
+      s_chkpt->queue_checkpoint("chkpt." + std::to_string(checkpoint_points[i]));
+    }
+    s_chkpt->finish_checkpoints();
+    return 0;
+  }
+
   #ifdef RISCV_MICRO_CHECKER
+  if (s_isa) {
     s_isa->boot();
+    // Snapshots checkpoint the ISA sim too: log its HTIF from the start.
+    if (snapshots)
+      s_isa->init_checkpoint("");
 
-    if (checkpoint_file != "")
+    if (resume_dir != "")
+    {
+      fprintf(stderr, "Resuming ISA sim from %s\n", resume_dir.c_str());
+      s_isa->restore_checkpoint(resume_dir + "/chkpt.isa");
+    }
+    else if (checkpoint_file != "")
     {
       fprintf(stderr, "Restoring checkpoint from %s\n",checkpoint_file.c_str());
       s_isa->restore_checkpoint(checkpoint_file);
@@ -532,19 +952,27 @@ int main(int argc, char** argv)
       htif_code = s_isa->run_fast(skip_amt);
       //htif_code = s_isa->create_checkpoint();
     }
-
-    // Fill the debug buffer
-    DB->run_ahead();
+  }
   #endif
 
 
   s_micro->boot();
   //exit(0);
+  if (snapshots)
+    s_micro->init_checkpoint("");
 
-  if (checkpoint_file != "")
+  if (resume_dir != "")
+  {
+      fprintf(stderr, "Resuming MICROS from %s\n", resume_dir.c_str());
+      // The ISA sim has run ahead: the two memory images differ.
+      s_micro->restore_checkpoint(resume_dir + "/chkpt");
+      s_micro->restore_snapshot(resume_dir);
+  }
+  else if (checkpoint_file != "")
   {
       fprintf(stderr, "Restoring checkpoint from %s\n",checkpoint_file.c_str());
-      s_micro->restore_checkpoint(checkpoint_file);
+      // Shares the memory image the ISA sim restored, if there is one.
+      s_micro->restore_checkpoint(checkpoint_file, s_isa);
   }
   else if (skip_enable) {
       // If skip amount is provided, fast skip in the MICROS sim
@@ -558,13 +986,42 @@ int main(int argc, char** argv)
   // Stop simulation if HTIF returns non-zero code
   //if(!htif_code) return htif_code;
 
+  // A configuration sweep forks here, after the skip or restore. Each child
+  // goes on below with its own configuration; the parent waits for them all.
+  if (!sweep_points.empty() && !fork_sweep(parser, argv[0], sweep_points, htif_code))
+    return htif_code;
+
+  #ifdef RISCV_MICRO_CHECKER
+  // Fill the debug buffer.
+  // This is done after restoring the timing simulator, which may share the
+  // ISA sim's restored memory image.
+  // A resumed debug buffer is already full.
+  if (DB && (resume_dir == ""))
+    DB->run_ahead();
+  #endif
+
+  if (snapshot_interval)
+    s_micro->init_snapshots(snapshot_dir, snapshot_interval);
+
   // Turn on logging if user requested logging from the start of timing simulation.
   if(logging_on_at == 0)
     logging_on = true;
 
+  #ifdef RISCV_MICRO_CHECKER
+    // From here on, the ISA sim is only stepped through the debug buffer.
+    if (DB)
+      DB->start_thread();
+  #endif
+
   fprintf(stderr, "Starting MICROS\n");
-  htif_code = s_micro->run();
+  htif_code = (SAMPLE_PERIOD ? s_micro->run_sampled() : s_micro->run());
   fprintf(stderr, "Stopping MICROS: HTIF Exit Code %d\n",htif_code);
+  fprintf(stderr, "Target memory written: %lu KB\n", s_micro->get_dirty_pages().count()*(PGSIZE/1024));
+
+  #ifdef RISCV_MICRO_CHECKER
+    if (DB)
+      DB->stop_thread();
+  #endif
 
   //*** Must delete the simulator instances in order to dump stats ***
   // Stats are dumped in the destructor for the processor instances.
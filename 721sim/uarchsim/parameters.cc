@@ -27,6 +27,7 @@ uint32_t FETCH_WIDTH	    = 8;//2;//4;
 uint32_t DISPATCH_WIDTH	  = 8;//2;//4;
 uint32_t ISSUE_WIDTH	    = 8;//3;//8;
 uint32_t RETIRE_WIDTH	    = 8;//1;//4;
+uint32_t LOAD_REPLAY_WIDTH = 1;	// Maximum number of stalled loads that can unstall per cycle.
 bool IC_INTERLEAVED		    = false;
 bool IC_SINGLE_BB		      = false;	// not used currently
 bool IN_ORDER_ISSUE		    = false;	// not used currently
@@ -136,3 +137,24 @@ uint64_t stop_amt                   = 0xffffffffffffffff;
 
 uint64_t phase_interval             = 10000;
 uint64_t verbose_phase_counters     = true;
+
+uint64_t SIMPOINT_INTERVAL          = 0;	// SimPoint profiling: basic block vector interval (0: no profiling).
+unsigned int SIMPOINT_MAX_K         = 10;	// SimPoint profiling: at most this many simulation points.
+
+uint64_t SAMPLE_PERIOD              = 0;	// Sampling: one unit is measured every this many instructions (0: no sampling).
+uint64_t SAMPLE_UNIT                = 1000;	// Sampling: instructions per measured unit.
+uint64_t SAMPLE_WARMUP              = 2000;	// Sampling: instructions of detailed warmup before each unit.
+double SAMPLE_ERROR                 = 0.03;	// Sampling: stop once the CPI confidence interval is within this relative error (0: never stop early).
+bool FUNCTIONAL_WARMING             = false;	// Fast skip trains the timing simulator's caches and branch predictors.
+
+uint64_t LIVE_STATS_INTERVAL        = 0;	// Live statistics: update the shared region live.<proc>.stats every this many cycles (0: no region).
+
+// Simulation speed.
+bool FAST_FORWARD_IDLE              = true;	// Skip over cycles in which no stage can make progress.
+bool FAST_IQ                        = true;	// Issue queue: consumer-list wakeup and ready-bitset select instead of full scans.
+bool CHECKER                        = true;	// Check every retired instruction against the ISA simulator.
+bool MEM_HUGEPAGE                   = false;	// Back target memory with transparent huge pages (for dense footprints).
+unsigned int ISA_THREAD             = 1;	// ISA checker simulator on its own host thread: 0 (never), 1 (if the host has more than one CPU), 2 (always).
+bool CHECKPOINT_COMPRESS            = false;	// Compress checkpoint pages (in independent blocks) when creating a checkpoint.
+unsigned int CHECKPOINT_THREADS     = 0;	// Threads compressing/decompressing checkpoint blocks (0: one per host CPU).
+unsigned int SWEEP_JOBS             = 0;	// Configuration sweep: at most this many configurations simulated at once (0: one per host CPU).
@@ -27,6 +27,7 @@ extern unsigned int FETCH_WIDTH;
 extern unsigned int DISPATCH_WIDTH;
 extern unsigned int ISSUE_WIDTH;
 extern unsigned int RETIRE_WIDTH;
+extern unsigned int LOAD_REPLAY_WIDTH;
 extern bool         IC_INTERLEAVED;
 extern bool         IC_SINGLE_BB;		// not used currently
 extern bool         IN_ORDER_ISSUE;		// not used currently
@@ -104,4 +105,25 @@ extern uint64_t stop_amt;
 extern uint64_t phase_interval;
 extern uint64_t verbose_phase_counters;
 
+extern uint64_t SIMPOINT_INTERVAL;
+extern unsigned int SIMPOINT_MAX_K;
+
+extern uint64_t SAMPLE_PERIOD;
+extern uint64_t SAMPLE_UNIT;
+extern uint64_t SAMPLE_WARMUP;
+extern double SAMPLE_ERROR;
+extern bool FUNCTIONAL_WARMING;
+
+extern uint64_t LIVE_STATS_INTERVAL;
+
+// Simulation speed.
+extern bool FAST_FORWARD_IDLE;
+extern bool FAST_IQ;
+extern bool CHECKER;
+extern unsigned int ISA_THREAD;
+extern bool MEM_HUGEPAGE;
+extern bool CHECKPOINT_COMPRESS;
+extern unsigned int CHECKPOINT_THREADS;
+extern unsigned int SWEEP_JOBS;
+
 #endif //PARAMETERS_H
@@ -1,6 +1,7 @@
 #include "debug.h"
 #include "pipeline.h"
 #include "payload.h"
+#include "snapshot.h"
 
 #include <new> // make sure we can use the placement new syntax
 
@@ -78,6 +79,42 @@ void trap_storage_t::clear() {
 	content_valid = false;
 }
 
+void trap_storage_t::snapshot(snapshot_t &s) {
+	bool valid = content_valid;
+	reg_t cause = 0;
+	reg_t badvaddr = 0;
+	if (valid) {
+		cause = get()->cause();
+		if (dynamic_cast<mem_trap_t *>(get()))
+			badvaddr = dynamic_cast<mem_trap_t *>(get())->get_badvaddr();
+	}
+	s.io(valid);
+	s.io(cause);
+	s.io(badvaddr);
+
+	if (!s.saving()) {
+		clear();
+		if (valid) {
+			switch (cause) {
+				case CAUSE_MISALIGNED_FETCH:       post(trap_instruction_address_misaligned(badvaddr)); break;
+				case CAUSE_FAULT_FETCH:            post(trap_instruction_access_fault(badvaddr)); break;
+				case CAUSE_ILLEGAL_INSTRUCTION:    post(trap_illegal_instruction()); break;
+				case CAUSE_PRIVILEGED_INSTRUCTION: post(trap_privileged_instruction()); break;
+				case CAUSE_FP_DISABLED:            post(trap_fp_disabled()); break;
+				case CAUSE_SYSCALL:                post(trap_syscall()); break;
+				case CAUSE_BREAKPOINT:             post(trap_breakpoint()); break;
+				case CAUSE_MISALIGNED_LOAD:        post(trap_load_address_misaligned(badvaddr)); break;
+				case CAUSE_MISALIGNED_STORE:       post(trap_store_address_misaligned(badvaddr)); break;
+				case CAUSE_FAULT_LOAD:             post(trap_load_access_fault(badvaddr)); break;
+				case CAUSE_FAULT_STORE:            post(trap_store_access_fault(badvaddr)); break;
+				case CAUSE_ACCELERATOR_DISABLED:   post(trap_accelerator_disabled()); break;
+				case CAUSE_CSR_INSTRUCTION:        post(trap_csr_instruction()); break;
+				default:                           assert(0);
+			}
+		}
+	}
+}
+
 payload::payload(unsigned int total_inflight_instr) {
 	assert(total_inflight_instr > 0);
 	unsigned int temp = 2*total_inflight_instr; // Need two PAY entries for each in-flight instruction to support splitting.
@@ -96,6 +133,7 @@ payload::payload(unsigned int total_inflight_instr) {
 	   assert((PAYLOAD_BUFFER_SIZE > 2*total_inflight_instr) && (PAYLOAD_BUFFER_SIZE < 4*total_inflight_instr));
 
 	buf = new payload_t[PAYLOAD_BUFFER_SIZE];
+	cold_buf = new payload_cold_t[PAYLOAD_BUFFER_SIZE];
 	clear();
 }
 
@@ -146,7 +184,7 @@ void payload::split(unsigned int index) {
 	buf[index+1].fu               = buf[index].fu;
 	buf[index+1].latency          = buf[index].latency;
 	buf[index+1].checkpoint       = buf[index].checkpoint;
-	buf[index+1].split_store      = buf[index].split_store;
+	cold_buf[index+1].split_store      = cold_buf[index].split_store;
 
 	buf[index+1].A_valid          = false;
 	buf[index+1].B_valid          = false;
@@ -154,11 +192,11 @@ void payload::split(unsigned int index) {
 
 	////////////////////////
 
-	buf[index].split = true;
-	buf[index].upper = true;
+	cold_buf[index].split = true;
+	cold_buf[index].upper = true;
 
-	buf[index+1].split = true;
-	buf[index+1].upper = false;
+	cold_buf[index+1].split = true;
+	cold_buf[index+1].upper = false;
 }
 
 // Mapping of instructions to actual (functional simulation) instructions.
@@ -167,6 +205,13 @@ void payload::map_to_actual(pipeline_t* proc, unsigned int index) {
 	bool         first;
 	debug_index_t db_index;
 
+	// Without an ISA simulator, no instruction can be linked.
+	if (!proc->get_pipe()) {
+		buf[index].good_instruction = false;
+		buf[index].db_index = DEBUG_INDEX_INVALID;
+		return;
+	}
+
 	//////////////////////////////
 	// Find previous instruction.
 	//////////////////////////////
@@ -320,6 +365,24 @@ void payload::dump(pipeline_t* proc,unsigned int index,FILE* file)
   ifprintf(logging_on,file,"\n");
 }
 
+void payload::snapshot(snapshot_t &s) {
+   s.check(PAYLOAD_BUFFER_SIZE, "payload buffer size");
+   s.io(buf, PAYLOAD_BUFFER_SIZE);
+   for (unsigned int i = 0; i < PAYLOAD_BUFFER_SIZE; i++) {
+      // The cold fields one by one: the trap is not plain data.
+      s.io(cold_buf[i].split);
+      s.io(cold_buf[i].upper);
+      s.io(cold_buf[i].split_store);
+      s.io(cold_buf[i].left);
+      s.io(cold_buf[i].right);
+      s.io(cold_buf[i].CSR_addr);
+      cold_buf[i].trap.snapshot(s);
+   }
+   s.io(head);
+   s.io(tail);
+   s.io(length);
+}
+
 unsigned int payload::get_size() {
    return(PAYLOAD_BUFFER_SIZE);
 }
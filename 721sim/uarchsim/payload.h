@@ -8,6 +8,8 @@
 #include "fetchunit_types.h"
 #include <cstdio>
 
+class snapshot_t;
+
 typedef
 enum {
    SEL_IQ,			// Select unified IQ.
@@ -56,45 +58,32 @@ public:
 	void clear();
 
 	bool valid() { return content_valid; };
-};
-
-typedef struct {
-
-   ////////////////////////
-   // Set by Fetch1 Stage.
-   ////////////////////////
-
-   insn_t inst;                 // The RISCV instruction.
-   reg_t pc;                    // The instruction's PC.
-   reg_t next_pc;               // The next instruction's PC. (I.e., the PC of the instruction fetched after this one.)
-   bool branch;				// This instruction was identified as a branch, by the BTB (if bundle came from instr. cache) or by the trace cache.
-   btb_branch_type_e branch_type;	// If the instruction was identified as a branch, this is its type.
-   uint64_t branch_target;        // If the instruction was identified as a branch, this is its taken target (not valid for indirect branches).
-
-   bool good_instruction;       // If 'true', this instruction has a
-                                // corresponding instruction in the
-                                // functional simulator. This implies the
-                                // instruction is on the correct control-flow
-                                // path.
-
-   debug_index_t db_index;      // Index of corresponding instruction in the
-                                // functional simulator
-                                // (if good_instruction == 'true').
-                                // Having this index is useful for obtaining
-                                // oracle information about the instruction,
-                                // for various oracle modes of the simulator.
 
-   // FIX_ME: not currently set/incremented
-   uint64_t sequence;           // Unique sequence number for speculatively
-                                // fetched instructions.  Helpful for
-                                // logging (debug traces).
+	// Saves the trap's cause (and bad address), and re-posts it on restore.
+	void snapshot(snapshot_t &s);
+};
 
-   ////////////////////////
-   // Set by Fetch2 Stage.
-   ////////////////////////
+////////////////////////////////////////////////////////////////////////
+//
+// The payload is split into a hot part (payload_t) and a cold part
+// (payload_cold_t), held in two parallel arrays indexed by the same
+// payload index.
+//
+// payload_t holds everything the scheduling loop touches every cycle
+// (operand valid bits, logical/physical registers, flags, FU type,
+// branch ID, AL/LQ/SQ indices, lane) at the front of the struct,
+// followed by the fetch-time and value fields used by the stages that
+// read/write operands.
+//
+// payload_cold_t holds fields that are only consulted on rare paths:
+// exceptions, CSR instructions, and split instructions.  Keeping them
+// out of payload_t shrinks the hot entry.  Access them with
+// PAY.cold(index).  The ISA checker's debug index stays in payload_t:
+// fetch, dispatch and retire read it for every instruction.
+//
+////////////////////////////////////////////////////////////////////////
 
-   unsigned int pred_tag;       // If the instruction is a branch, this is its
-                                // index into the Fetch Unit's branch queue.
+typedef struct {
 
    ////////////////////////
    // Set by Decode Stage.
@@ -103,64 +92,37 @@ typedef struct {
    unsigned int flags;          // Operation flags: can be used for quickly
                                 // deciphering the type of instruction.
    fu_type fu;                  // Operation function unit type.
-   cycle_t latency;             // Operation latency (ignore: not currently used).
 
-   bool checkpoint;             // If 'true', this instruction is a branch
-                                // that needs a checkpoint.
-
-   // Note: At present, the decode stage does not split RISCV instructions
-   // into micro-instructions.  Nonetheless, the pipeline does support
-   // split instructions.
-   bool split;                  // Instruction is split into two micro-ops.
-   bool upper;                  // If 'true': this instruction is the upper
-                                // half of a split instruction.
-                                // If 'false': this instruction is the lower
-                                // half of a split instruction.
-   bool split_store;            // Instruction is a split-store.
+   // IQ selection.
+   sel_iq iq;                   // The value of this enumerated type indicates
+                                // whether to place the instruction in the
+                                // issue queue, skip it, or skip it with
+                                // an exception.
+                                // (The 'sel_iq' enumerated type is also
+                                // defined in this file.)
 
    // Source register A.
    bool A_valid;                // If 'true', the instruction has a
                                 // first source register.
-   unsigned int A_log_reg;      // The logical register specifier of the
-                                // source register.
-
    // Source register B.
    bool B_valid;                // If 'true', the instruction has a
                                 // second source register.
-   unsigned int B_log_reg;      // The logical register specifier of the
-                                // source register.
-
    // ** DESTINATION ** register C.
    bool C_valid;                // If 'true', the instruction has a
                                 // destination register.
-   unsigned int C_log_reg;      // The logical register specifier of the
-                                // destination register.
-
    // ** SOURCE ** register D.
    // Floating-point multiply-accumulate uses a third source register.
    bool D_valid;                // If 'true', the instruction has a
                                 // third source register.
-   unsigned int D_log_reg;      // The logical register specifier of the
-                                // source register.
 
-   // IQ selection.
-   sel_iq iq;                   // The value of this enumerated type indicates
-                                // whether to place the instruction in the
-                                // issue queue, skip it, or skip it with
-                                // an exception.
-                                // (The 'sel_iq' enumerated type is also
-                                // defined in this file.)
-
-   uint64_t CSR_addr;           // System register address, for privileged
-                                // instructions that reference and/or modify
-                                // a specified system register.
-
-   // Details about loads and stores.
-   unsigned int size;           // Size of load or store (1, 2, 4, or 8 bytes).
-   bool is_signed;              // If 'true', the loaded value is signed,
-                                // else it is unsigned.
-   bool left;			// Relic of PISA ISA - no longer used.
-   bool right;			// Relic of PISA ISA - no longer used.
+   unsigned int A_log_reg;      // The logical register specifier of the
+                                // first source register.
+   unsigned int B_log_reg;      // The logical register specifier of the
+                                // second source register.
+   unsigned int C_log_reg;      // The logical register specifier of the
+                                // destination register.
+   unsigned int D_log_reg;      // The logical register specifier of the
+                                // third source register.
 
    ////////////////////////
    // Set by Rename Stage.
@@ -191,12 +153,68 @@ typedef struct {
 
    unsigned int AL_index;       // Index into Active List.
    unsigned int LQ_index;       // Indices into LSU. Only used by loads, stores, and branches.
-   bool LQ_phase;
    unsigned int SQ_index;
+   bool LQ_phase;
    bool SQ_phase;
 
+   ////////////////////////
+   // Set by Decode Stage.
+   ////////////////////////
+
+   bool checkpoint;             // If 'true', this instruction is a branch
+                                // that needs a checkpoint.
+
+   // Details about loads and stores.
+   bool is_signed;              // If 'true', the loaded value is signed,
+                                // else it is unsigned.
+   unsigned int size;           // Size of load or store (1, 2, 4, or 8 bytes).
+
+   ////////////////////////
+   // Set by Dispatch Stage.
+   ////////////////////////
+
    unsigned int lane_id;        // Execution lane chosen for the instruction.
 
+   ////////////////////////
+   // Set by Fetch1 Stage.
+   ////////////////////////
+
+   insn_t inst;                 // The RISCV instruction.
+   reg_t pc;                    // The instruction's PC.
+   reg_t next_pc;               // The next instruction's PC. (I.e., the PC of the instruction fetched after this one.)
+   bool branch;				// This instruction was identified as a branch, by the BTB (if bundle came from instr. cache) or by the trace cache.
+   bool good_instruction;       // If 'true', this instruction has a
+                                // corresponding instruction in the
+                                // functional simulator. This implies the
+                                // instruction is on the correct control-flow
+                                // path.
+   debug_index_t db_index;      // Index of corresponding instruction in the
+                                // functional simulator
+                                // (if good_instruction == 'true').
+                                // Having this index is useful for obtaining
+                                // oracle information about the instruction,
+                                // for various oracle modes of the simulator.
+   btb_branch_type_e branch_type;	// If the instruction was identified as a branch, this is its type.
+   uint64_t branch_target;        // If the instruction was identified as a branch, this is its taken target (not valid for indirect branches).
+
+   // FIX_ME: not currently set/incremented
+   uint64_t sequence;           // Unique sequence number for speculatively
+                                // fetched instructions.  Helpful for
+                                // logging (debug traces).
+
+   ////////////////////////
+   // Set by Fetch2 Stage.
+   ////////////////////////
+
+   unsigned int pred_tag;       // If the instruction is a branch, this is its
+                                // index into the Fetch Unit's branch queue.
+
+   ////////////////////////
+   // Set by Decode Stage.
+   ////////////////////////
+
+   cycle_t latency;             // Operation latency (ignore: not currently used).
+
    ////////////////////////
    // Set by Reg. Read Stage.
    ////////////////////////
@@ -229,10 +247,39 @@ typedef struct {
 
    uint32_t fflags;             // If it is a FP instruction, this is the new fflags bits it will post
 
-   // If there was an exception during execution, the trap is stored here.
+} payload_t;
+
+typedef struct {
+
+   ////////////////////////
+   // Set by Decode Stage.
+   ////////////////////////
+
+   // Note: At present, the decode stage does not split RISCV instructions
+   // into micro-instructions.  Nonetheless, the pipeline does support
+   // split instructions.
+   bool split;                  // Instruction is split into two micro-ops.
+   bool upper;                  // If 'true': this instruction is the upper
+                                // half of a split instruction.
+                                // If 'false': this instruction is the lower
+                                // half of a split instruction.
+   bool split_store;            // Instruction is a split-store.
+
+   bool left;			// Relic of PISA ISA - no longer used.
+   bool right;			// Relic of PISA ISA - no longer used.
+
+   uint64_t CSR_addr;           // System register address, for privileged
+                                // instructions that reference and/or modify
+                                // a specified system register.
+
+   ////////////////////////
+   // Set by any stage.
+   ////////////////////////
+
+   // If there was an exception, the trap is stored here.
    trap_storage_t trap;
 
-} payload_t;
+} payload_cold_t;
 
 
 //Forward declaring pipeline_t class as pointer is passed to the dump function
@@ -258,6 +305,7 @@ public:
 	////////////////////////////////////////////////////////////////////////
         unsigned int PAYLOAD_BUFFER_SIZE;
 	payload_t    *buf;
+	payload_cold_t *cold_buf;	// Rarely used fields, parallel to buf.
 	unsigned int head;
 	unsigned int tail;
 	int          length;
@@ -278,6 +326,11 @@ public:
 	void predict(pipeline_t *proc, uint64_t pc, uint64_t max_length, uint64_t &cb_predictions, uint64_t &indirect_target);
 
 	unsigned int get_size();
+
+	void snapshot(snapshot_t &s);
+
+	// Cold (rarely used) fields of the instruction at 'index'.
+	inline payload_cold_t &cold(unsigned int index) { return(cold_buf[index]); }
 };
 
 #endif //PAYLOAD_H
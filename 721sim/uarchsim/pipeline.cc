@@ -7,6 +7,7 @@
 #include "sim.h"
 #include "htif.h"
 #include "disasm.h"
+#include "snapshot.h"
 #include <cinttypes>
 #include <cmath>
 #include <cstdlib>
@@ -78,7 +79,7 @@ pipeline_t::pipeline_t(
   PAY(2*fetch_width + fq_size /* FETCH2, DECODE, FQ */ + 2*dispatch_width + rob_size /* RENAME2, DISPATCH, ROB */),
   FQ(fq_size,this),
   IQ(iq_size,iq_num_parts,this),
-  LSU(lq_size, sq_size, Tid, _mmu, this)
+  LSU(lq_size, sq_size, _id, _mmu, this)
 {
   unsigned int i, j, ex_depth;
 
@@ -91,6 +92,7 @@ pipeline_t::pipeline_t(
 
   // Initialize number of retired instructions.
   num_insn = 0;
+  retire_next_pc = 0;
   num_insn_split = 0;
 
 
@@ -317,6 +319,7 @@ pipeline_t::pipeline_t(
   fprintf(stats_log, "DISPATCH WIDTH = %d\n", dispatch_width);
   fprintf(stats_log, "ISSUE WIDTH = %d\n", issue_width);
   fprintf(stats_log, "RETIRE WIDTH = %d\n", retire_width);
+  fprintf(stats_log, "LOAD REPLAY WIDTH = %d\n", LOAD_REPLAY_WIDTH);
 
   fprintf(stats_log, "\n=== EXECUTION LANES =============================================================\n\n");
   fprintf(stats_log, "        |latency |   BR   |   LS   |  ALU_S |  ALU_C | LS_FP  | ALU_FP |  MTF   |\n");
@@ -392,12 +395,29 @@ pipeline_t::pipeline_t(
   reset(true);
   mmu->set_processor(this);
 
+  // Idle-cycle fast-forward: no cycle measured yet.
+  ff_armed = false;
+
+  /////////////////////////////////////////////////////////////
+  // Live statistics.
+  /////////////////////////////////////////////////////////////
+
+  live_stats_cycle = (cycle_t)-1;
+  live_stats_seen = live_stats_requests;
+  if (LIVE_STATS_INTERVAL) {
+     sprintf(tempstr, "live.%u.stats", Tid);
+     if (stats->open_live(tempstr))
+        live_stats_cycle = LIVE_STATS_INTERVAL;
+     else
+        fprintf(stderr, "Could not create the live statistics region %s.\n", tempstr);
+  }
 }
 
 
 pipeline_t::~pipeline_t()
 {
   //stats->dump_knobs();
+  stats->update_live(cycle, num_insn);
   stats->dump_counters();
   stats->update_rates();	// Need to call this before dump_rates() to ensure most up-to-date rates.
   stats->dump_rates();
@@ -413,9 +433,18 @@ pipeline_t::~pipeline_t()
   }
 #endif
 
-  FetchUnit->output(stats->get_counter("commit_count"), stats->get_counter("cycle_count"), stats_log);
+  FetchUnit->output(counter(commit_count), counter(cycle_count), stats_log);
   LSU.dump_stats(stats_log);
 
+  // Per-level cache summary.
+  CacheClass::dump_summary_header(stats_log);
+  FetchUnit->get_ic()->dump_summary(stats_log);
+  LSU.get_dc()->dump_summary(stats_log);
+  if (L2C)
+    L2C->dump_summary(stats_log);
+  if (L3C)
+    L3C->dump_summary(stats_log);
+
   #ifdef RISCV_MICRO_DEBUG
     fclose(this->fetch_log    );
     fclose(this->decode_log   );
@@ -535,6 +564,14 @@ bool pipeline_t::step_micro(size_t instret_limit, size_t& instret)
 
         size_t lane_number;
 
+        // Only a cycle that starts and ends with empty Execution Lanes can be idle.
+        bool ff_measure = FAST_FORWARD_IDLE && !logging_on && !stats->phase_counting() && lanes_empty();
+        if (ff_measure) {
+          get_idle_sig(ff_sig);
+          if (ff_armed)
+            stats->snapshot_counters(ff_counters);
+        }
+
         unsigned int prev_commit_count = counter(commit_count);
         for (lane_number = 0; lane_number < RETIRE_WIDTH; lane_number++) {
           retire(instret);            // Retire Stage
@@ -544,7 +581,8 @@ bool pipeline_t::step_micro(size_t instret_limit, size_t& instret)
           if(instret == instret_limit)
             break;
           // Stop simulation if limit reached
-          if((counter(commit_count) >= stop_amt) && use_stop_amt){
+          // num_insn, unlike commit_count, is not rolled back after a sampling warmup.
+          if((num_insn >= stop_amt) && use_stop_amt){
             //stats->dump_knobs();
             //stats->dump_counters();
             //stats->dump_rates();
@@ -614,6 +652,16 @@ bool pipeline_t::step_micro(size_t instret_limit, size_t& instret)
 	  num_insn_last_beat = num_insn;
         }
 
+        // If no stage made progress this cycle, skip ahead to the next cycle in which one can.
+        if (ff_measure)
+          fast_forward();
+        else
+          ff_armed = false;
+
+        // Export live statistics, periodically or on request (SIGUSR1).
+        if ((cycle >= live_stats_cycle) || (live_stats_seen != live_stats_requests))
+          live_stats();
+
     }
   }
   //catch(mem_trap_t& t)
@@ -662,6 +710,71 @@ reg_t pipeline_t::take_trap(trap_t& t, reg_t epc)
   return state.evec;
 }
 
+// Refresh the live statistics region (if any) and, on request, also write
+// the snapshot as text to live.<tid>.log. Neither waits on a reader.
+void pipeline_t::live_stats() {
+  if (live_stats_seen != live_stats_requests) {
+    live_stats_seen = live_stats_requests;
+    char file[32];
+    sprintf(file, "live.%u.log", Tid);
+    stats->dump_live(file, cycle, num_insn);
+  }
+  stats->update_live(cycle, num_insn);
+  if (LIVE_STATS_INTERVAL)
+    live_stats_cycle = cycle - (cycle % LIVE_STATS_INTERVAL) + LIVE_STATS_INTERVAL;
+}
+
+void pipeline_t::snapshot(snapshot_t& s) {
+  s.check(fetch_width, "fetch width");
+  s.check(dispatch_width, "dispatch width");
+  s.check(issue_width, "issue width");
+  s.check(retire_width, "retire width");
+  s.check(L2C != NULL, "L2 cache present");
+  s.check(L3C != NULL, "L3 cache present");
+
+  s.io(sequence);
+  s.io(cycle);
+  s.io(num_insn);
+  s.io(num_insn_split);
+  s.io(retire_next_pc);
+  s.io(pc_histogram);
+  statsModule.snapshot(s);
+
+  PAY.snapshot(s);
+  FetchUnit->snapshot(s);
+  s.io(DECODE, fetch_width);
+  FQ.snapshot(s);
+  s.io(RENAME2, dispatch_width);
+  REN->snapshot(s);
+  s.io(DISPATCH, dispatch_width);
+  IQ.snapshot(s);
+  for (unsigned int i = 0; i < issue_width; i++)
+    Execution_Lanes[i].snapshot(s);
+  s.io(fu_lane_ptr, (unsigned int)NUMBER_FU_TYPES);
+  LSU.snapshot(s);
+  if (L2C)
+    L2C->snapshot(s);
+  if (L3C)
+    L3C->snapshot(s);
+
+  // The next periodic live statistics update follows the restored cycle.
+  if (!s.saving() && LIVE_STATS_INTERVAL && (live_stats_cycle != (cycle_t)-1))
+    live_stats_cycle = cycle - (cycle % LIVE_STATS_INTERVAL) + LIVE_STATS_INTERVAL;
+}
+
+void pipeline_t::measurements(snapshot_t& s) {
+  s.io(pc_histogram);
+  statsModule.measurements(s);
+  FetchUnit->measurements(s);
+  FetchUnit->get_ic()->measurements(s);
+  LSU.measurements(s);
+  LSU.get_dc()->measurements(s);
+  if (L2C)
+    L2C->measurements(s);
+  if (L3C)
+    L3C->measurements(s);
+}
+
 void pipeline_t::disasm(insn_t insn)
 {
   uint64_t bits = insn.bits() & ((1ULL << (8 * insn_length(insn.bits()))) - 1);
@@ -717,6 +830,42 @@ void pipeline_t::copy_state_to_micro() {
    }
 
    FetchUnit->setPC(get_state()->pc);
+   retire_next_pc = get_state()->pc;
+}
+
+void pipeline_t::copy_state_from_micro() {
+   // Squashing restores the rename map from the AMT.
+   squash_complete(retire_next_pc);
+   PAY.clear();
+
+   for (unsigned int i = 0; i < NXPR; i++){
+      get_state()->XPR.write(i, REN->read(REN->rename_rsrc(i)));
+      get_state()->FPR.write(i, REN->read(REN->rename_rsrc(i+NXPR)));
+   }
+
+   get_state()->pc = retire_next_pc;
+}
+
+void pipeline_t::warm(reg_t pc, insn_t insn, reg_t npc, reg_t rs1) {
+   FetchUnit->warm(pc, insn, npc);
+
+   if (PERFECT_DCACHE)
+      return;
+   switch (insn.opcode()) {
+      case OP_LOAD:
+      case OP_LOAD_FP:
+         LSU.get_dc()->Warm(Tid, rs1 + insn.i_imm(), false);
+         break;
+      case OP_STORE:
+      case OP_STORE_FP:
+         LSU.get_dc()->Warm(Tid, rs1 + insn.s_imm(), true);
+         break;
+      case OP_AMO:
+         LSU.get_dc()->Warm(Tid, rs1, true);
+         break;
+      default:
+         break;
+   }
 }
 
 uint64_t pipeline_t::get_arch_reg_value(int reg_id) { 
@@ -8,6 +8,7 @@
 #include <cstring>
 #include <vector>
 #include <map>
+#include <queue>
 #include <cassert>
 
 //////////////////////////////////////////////////////////////////////////////
@@ -149,6 +150,36 @@
 //};
 
 
+// Everything that changes when some pipeline stage makes progress.
+// If it is the same before and after a cycle, that cycle was idle (see idle.cc).
+typedef struct {
+	unsigned int pay_head;
+	unsigned int pay_tail;
+
+	reg_t fetch_pc;
+	bool fetch_active;
+	bool fetch2_valid;
+	bool ic_miss;
+	cycle_t ic_miss_resolve;
+
+	bool decode_valid;
+	unsigned int decode_index;
+	unsigned int fq_length;
+	bool rename2_valid;
+	unsigned int rename2_index;
+	bool dispatch_valid;
+	unsigned int dispatch_index;
+
+	unsigned int iq_length;
+	unsigned int lq_length;
+	unsigned int sq_length;
+
+	uint64_t commit_count;
+	uint64_t recovery_count;
+	uint64_t load_replay_count;	// a replayed load, even if it stays stalled, changes the LSU
+} idle_sig_t;
+
+
 // this class represents one processor in a RISC-V machine.
 class pipeline_t: public processor_t
 {
@@ -213,9 +244,22 @@ public:
   // Copy registers from fast skip state to pipeline register file.
   // Also reset the AMT.
   void copy_state_to_micro();
+  // Squash the pipeline at the retire point and copy the architectural
+  // registers and PC back to the fast skip state (the inverse of
+  // copy_state_to_micro()), so that fast skip can continue from there.
+  void copy_state_from_micro();
+  // Functional warming during fast skip: the instruction fetch, branch
+  // outcome, and load/store address train the fetch unit and the caches.
+  virtual void warm(reg_t pc, insn_t insn, reg_t npc, reg_t rs1);
   uint64_t get_arch_reg_value(int reg_id); 
   uint64_t get_pc(){return get_state()->pc;}
   uint32_t get_instruction(uint64_t inst_pc);
+  // Save or restore the entire timing state: every pipeline register,
+  // queue, predictor and cache, and the stats (see sim_t::write_snapshot()).
+  void snapshot(snapshot_t& s);
+  // Save or restore only what is reported at the end of the run: the stats
+  // and histograms, and the fetch unit's, LSU's and caches' measurements.
+  void measurements(snapshot_t& s);
 
 private:
 //	sim_t* sim;
@@ -358,6 +402,19 @@ private:
 	CacheClass* L2C;
 	CacheClass* L3C;
 
+	/////////////////////////////////////////////////////////////
+	// Idle-cycle fast-forward.
+	/////////////////////////////////////////////////////////////
+	idle_sig_t ff_sig;			// State at the start of the cycle being measured.
+	std::vector<uint64_t> ff_counters;	// Stats counters at the start of the cycle being measured.
+	bool ff_armed;				// The previous cycle was idle: measure this cycle's stats increments.
+
+	/////////////////////////////////////////////////////////////
+	// Live statistics.
+	/////////////////////////////////////////////////////////////
+	cycle_t live_stats_cycle;		// Next periodic update of the live statistics region.
+	sig_atomic_t live_stats_seen;		// Requests (SIGUSR1) served so far.
+
 	//////////////////////
 	// PRIVATE FUNCTIONS
 	//////////////////////
@@ -374,6 +431,11 @@ private:
 
   void phase_stats();
 
+  bool lanes_empty();
+  cycle_t get_idle_sig(idle_sig_t& sig);
+  void fast_forward();
+  void live_stats();
+
   bool execute_amo();
   bool execute_csr();
 
@@ -389,6 +451,9 @@ public:
 	uint64_t num_insn;
 	uint64_t num_insn_split;
 
+	// PC of the instruction after the last one retired.
+	reg_t retire_next_pc;
+
 
 	// Functions for pipeline stages.
 	void fetch();
@@ -1,9 +1,10 @@
 #include <cinttypes>
 #include "ras.h"
+#include "snapshot.h"
 
 ras_t::ras_t(uint64_t size) {
    this->size = ((size > 0) ? size : 1);
-   ras = new uint64_t[this->size];
+   ras = new uint64_t[this->size]();
    tos = 0;
 }
 
@@ -40,3 +41,8 @@ void ras_t::set_tos(uint64_t tos) {
    this->tos = tos;
 }
 
+void ras_t::snapshot(snapshot_t &s) {
+   s.check(size, "RAS size");
+   s.io(ras, size);
+   s.io(tos);
+}
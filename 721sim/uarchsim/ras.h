@@ -1,4 +1,6 @@
 
+class snapshot_t;
+
 class ras_t {
 private:
 	uint64_t *ras;
@@ -15,4 +17,7 @@ public:
 	// Functions to get and set the top-of-stack index, e.g., for checkpoint/restore purposes.
 	uint64_t get_tos();
 	void set_tos(uint64_t tos);
+
+	// Save or restore the RAS contents and the top-of-stack index.
+	void snapshot(snapshot_t &s);
 };
@@ -1,6 +1,7 @@
 #define __STDC_FORMAT_MACROS
 
 #include "renamer.h"
+#include "snapshot.h"
 #include <cassert>
 
 renamer::renamer(uint64_t n_log_regs,
@@ -745,3 +746,41 @@ bool renamer::reg_in_rmt(uint64_t phys_reg){
     }
     return false;
 }
+
+void renamer::snapshot(snapshot_t &s){
+    s.check(map_table_size, "logical registers");
+    s.check(num_phys_reg, "physical registers");
+    s.check(active_list_size, "active list size");
+    s.check(num_checkpoints, "branch checkpoints");
+
+    s.io(rmt, map_table_size);
+    s.io(amt, map_table_size);
+    s.io(prf, num_phys_reg);
+    s.io(prf_ready, num_phys_reg);
+
+    s.io(al.head);
+    s.io(al.head_phase);
+    s.io(al.tail);
+    s.io(al.tail_phase);
+    s.io(al.list, active_list_size);
+
+    s.io(fl.head);
+    s.io(fl.head_phase);
+    s.io(fl.tail);
+    s.io(fl.tail_phase);
+    s.io(fl.list, free_list_size);
+
+    //Only the allocated checkpoints (GBM bits) hold anything
+    s.io(GBM);
+    uint64_t i;
+    for (i=0; i < num_checkpoints; i++){
+        if (!(GBM & (1ULL<<i)))
+            continue;
+        if (!s.saving())
+            checkpoints[i].shadow_map_table = new uint64_t[shadow_map_table_size];
+        s.io(checkpoints[i].shadow_map_table, shadow_map_table_size);
+        s.io(checkpoints[i].free_list_head);
+        s.io(checkpoints[i].free_list_head_phase);
+        s.io(checkpoints[i].gbm);
+    }
+}
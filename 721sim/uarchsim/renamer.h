@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+class snapshot_t;
+
 class renamer {
 private:
     /////////////////////////////////////////////////////////////////////
@@ -579,4 +581,10 @@ public:
     /////////////////////////////////////////////////////////////////////
     bool get_exception(uint64_t AL_index);
 
+    /////////////////////////////////////////////////////////////////////
+    // Save or restore the map tables, free list, active list, physical
+    // register file, and branch checkpoints.
+    /////////////////////////////////////////////////////////////////////
+    void snapshot(snapshot_t &s);
+
 };
@@ -109,7 +109,7 @@ void pipeline_t::retire(size_t& instret) {
 	 num_insn++;
          instret++;
 	 inc_counter(commit_count);
-	 if (PAY.buf[PAY.head].split && PAY.buf[PAY.head].upper)
+	 if (PAY.cold(PAY.head).split && PAY.cold(PAY.head).upper)
             num_insn_split++;
 
 	 if (amo || csr) {   // Resume the stalled fetch unit after committing a serializing instruction.
@@ -122,9 +122,10 @@ void pipeline_t::retire(size_t& instret) {
 
 	    // The serializing instruction stalled the fetch unit so the pipeline is now empty. Resume fetch.
             FetchUnit->flush(next_inst_pc);
+            retire_next_pc = next_inst_pc;
 
 	    // Pop the instruction from PAY.
-	    if (!PAY.buf[PAY.head].split) PAY.pop();
+	    if (!PAY.cold(PAY.head).split) PAY.pop();
 	    PAY.pop();
 	 }
 	 else if (br_misp || val_misp) {   // Complete-squash the pipeline after committing a mispredicted branch or
@@ -139,17 +140,20 @@ void pipeline_t::retire(size_t& instret) {
 	    // Squash all instructions after it.
             squash_complete(next_inst_pc);
             inc_counter(recovery_count);
+            retire_next_pc = next_inst_pc;
 
 	    // Pop the instruction from PAY.
-	    if (!PAY.buf[PAY.head].split) PAY.pop();
+	    if (!PAY.cold(PAY.head).split) PAY.pop();
 	    PAY.pop();
 
             // Flush PAY.
             PAY.clear();
          }
          else {
+            retire_next_pc = (branch ? PAY.buf[PAY.head].c_next_pc : INCREMENT_PC(PAY.buf[PAY.head].pc));
+
 	    // Pop the instruction from PAY.
-	    if (!PAY.buf[PAY.head].split) PAY.pop();
+	    if (!PAY.cold(PAY.head).split) PAY.pop();
 	    PAY.pop();
          }
       }
@@ -165,12 +169,13 @@ void pipeline_t::retire(size_t& instret) {
          squash_complete(offending_PC);
          inc_counter(recovery_count);
          inc_counter(ld_vio_count);
+         retire_next_pc = offending_PC;
 
          // Flush PAY.
          PAY.clear();
       }
       else {   // exception
-         trap = PAY.buf[PAY.head].trap.get();
+         trap = PAY.cold(PAY.head).trap.get();
 
          // CSR exceptions are micro-architectural exceptions and are
          // not defined by the ISA. These must be handled exclusively by
@@ -197,6 +202,7 @@ void pipeline_t::retire(size_t& instret) {
          // Squash the pipeline.
          squash_complete(jump_PC);
          inc_counter(recovery_count);
+         retire_next_pc = jump_PC;
 
          // Flush PAY.
          PAY.clear();
@@ -293,7 +299,7 @@ bool pipeline_t::execute_amo() {
    catch (mem_trap_t& t) {
       exception = true;
       assert(t.cause() == CAUSE_FAULT_STORE || t.cause() == CAUSE_MISALIGNED_STORE);
-      PAY.buf[index].trap.post(t);
+      PAY.cold(index).trap.post(t);
    }
 
    // Record the loaded value in the payload buffer for checking purposes.
@@ -329,37 +335,37 @@ bool pipeline_t::execute_csr() {
       if (inst.funct3() != FN3_SC_SB) {
          switch (inst.funct3()) {
             case FN3_CLR:
-               csr = validate_csr(PAY.buf[index].CSR_addr, true);
+               csr = validate_csr(PAY.cold(index).CSR_addr, true);
 	       old_value = get_pcr(csr);
                new_value = (old_value & ~PAY.buf[index].A_value.dw);
                set_pcr(csr, new_value);
                break;
             case FN3_RW:
-               csr = validate_csr(PAY.buf[index].CSR_addr, true);
+               csr = validate_csr(PAY.cold(index).CSR_addr, true);
 	       old_value = get_pcr(csr);
                new_value = PAY.buf[index].A_value.dw;
                set_pcr(csr, new_value);
                break;
             case FN3_SET:
-               csr = validate_csr(PAY.buf[index].CSR_addr, (PAY.buf[index].A_log_reg != 0));
+               csr = validate_csr(PAY.cold(index).CSR_addr, (PAY.buf[index].A_log_reg != 0));
 	       old_value = get_pcr(csr);
                new_value = (old_value | PAY.buf[index].A_value.dw);
                set_pcr(csr, new_value);
                break;
             case FN3_CLR_IMM:
-               csr = validate_csr(PAY.buf[index].CSR_addr, true);
+               csr = validate_csr(PAY.cold(index).CSR_addr, true);
 	       old_value = get_pcr(csr);
                new_value = (old_value & ~(reg_t)PAY.buf[index].A_log_reg);
                set_pcr(csr, new_value);
                break;
             case FN3_RW_IMM:
-               csr = validate_csr(PAY.buf[index].CSR_addr, true);
+               csr = validate_csr(PAY.cold(index).CSR_addr, true);
 	       old_value = get_pcr(csr);
                new_value = (reg_t)PAY.buf[index].A_log_reg;
                set_pcr(csr, new_value);
                break;
             case FN3_SET_IMM:
-               csr = validate_csr(PAY.buf[index].CSR_addr, true);
+               csr = validate_csr(PAY.cold(index).CSR_addr, true);
 	       old_value = get_pcr(csr);
                new_value = (old_value | (reg_t)PAY.buf[index].A_log_reg);
                set_pcr(csr, new_value);
@@ -373,7 +379,7 @@ bool pipeline_t::execute_csr() {
          // This is a macro defined in decode.h.
          // This will throw a privileged_instruction trap if processor not in supervisor mode.
          require_supervisor; 
-         csr = validate_csr(PAY.buf[index].CSR_addr, true);
+         csr = validate_csr(PAY.cold(index).CSR_addr, true);
          old_value = get_pcr(csr);
          new_value = ((old_value & ~(SR_S | SR_EI)) | ((old_value & SR_PS) ? SR_S : 0) | ((old_value & SR_PEI) ? SR_EI : 0));
          set_pcr(csr, new_value);
@@ -395,11 +401,11 @@ bool pipeline_t::execute_csr() {
    catch (trap_t& t) {
       exception = true;
       assert(t.cause() == CAUSE_PRIVILEGED_INSTRUCTION || t.cause() == CAUSE_FP_DISABLED);
-      PAY.buf[index].trap.post(t);
+      PAY.cold(index).trap.post(t);
    }
    catch (serialize_t& s) {
       exception = true;
-      PAY.buf[index].trap.post(trap_csr_instruction());
+      PAY.cold(index).trap.post(trap_csr_instruction());
    }
 
    return(exception);
@@ -5,15 +5,34 @@
 #include <map>
 #include <iostream>
 #include <climits>
+#include <cmath>
 #include <cstdlib>
 #include <cassert>
 #include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <cstring>
+#include <cstddef>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <zlib.h>
 #include <gzstream.h>
 #include "pipeline.h"
+#include "bbtracker.h"
+#include "simpoint.h"
+#include "snapshot.h"
 
 volatile bool ctrlc_pressed = false;
+volatile sig_atomic_t end_requested = 0;
 static void handle_signal(int sig)
 {
 	if (ctrlc_pressed) {
@@ -24,8 +43,9 @@ static void handle_signal(int sig)
 }
 
 sim_t::sim_t(size_t nprocs, size_t mem_mb, const std::vector<std::string>& args, proc_type_t _proc_type)
-	: htif(new htif_isasim_t(this, args)), procs(std::max(nprocs, size_t(1))),
-	  current_step(0), idle_cycles(0), current_proc(0), debug(false), checkpointing_enabled(false)
+	: htif(new htif_isasim_t(this, args)), mem_image_fd(-1), procs(std::max(nprocs, size_t(1))),
+	  current_step(0), idle_cycles(0), current_proc(0), debug(false), checkpointing_enabled(false),
+	  chkpt_writer(NULL), snapshot_interval(0), next_snapshot(UINT64_MAX)
 {
 	signal(SIGINT, &handle_signal);
 	// allocate target machine's memory, shrinking it as necessary
@@ -38,15 +58,25 @@ sim_t::sim_t(size_t nprocs, size_t mem_mb, const std::vector<std::string>& args,
 
 	memsz = memsz0;
   ifprintf(logging_on,stderr, "Requesting target memory 0x%lx\n",(unsigned long)memsz0);
-	while ((mem = (char*)calloc(1, memsz)) == NULL) {
+	// Anonymous memory is zero-filled and committed a page at a time, on
+	// first touch, so a sparse target only costs the pages it uses.
+	while ((mem = (char*)mmap(NULL, memsz, PROT_READ|PROT_WRITE,
+	                          MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0)) == MAP_FAILED) {
 		memsz = memsz*10/11/quantum*quantum;
 	}
+#ifdef MADV_HUGEPAGE
+	if (MEM_HUGEPAGE)
+		madvise(mem, memsz, MADV_HUGEPAGE);
+#endif
 
 	if (memsz != memsz0)
 		fprintf(stderr, "warning: only got %lu bytes of target mem (wanted %lu)\n",
 		        (unsigned long)memsz, (unsigned long)memsz0);
 
+	dirty_pages = new page_bitmap_t((memsz + PGSIZE - 1) >> PGSHIFT);
+
 	debug_mmu = new mmu_t(mem, memsz, DEBUG_MMU); //set debug type true
+	debug_mmu->set_dirty_pages(dirty_pages);
 
   this->proc_type = _proc_type;
 
@@ -58,34 +88,65 @@ sim_t::sim_t(size_t nprocs, size_t mem_mb, const std::vector<std::string>& args,
 		  procs[i]->set_proc_type("ISA_SIM");
     }
     else{
-		  procs[i] = new pipeline_t(
-		      this,
           // Set this as MICRO_MMU so that mem operations
           // do not push to debug buffer. This is necessary
           // as we use the same class as ISA sim to instantiate
           // the mmu.
-		      new mmu_t(mem, memsz, MICRO_MMU),  
-		      i,
-		      FETCH_QUEUE_SIZE,
-		      NUM_CHECKPOINTS,
-		      ACTIVE_LIST_SIZE,
-		      (AUTO_PRF_SIZE ? (NXPR + NFPR + ACTIVE_LIST_SIZE) : PRF_SIZE),
-		      ISSUE_QUEUE_SIZE,
-		      ISSUE_QUEUE_NUM_PARTS,
-		      LQ_SIZE,
-		      SQ_SIZE,
-		      FETCH_WIDTH,
-		      DISPATCH_WIDTH,
-		      ISSUE_WIDTH,
-		      RETIRE_WIDTH,
-		      FU_LANE_MATRIX,
-		      FU_LAT);
-		  procs[i]->set_proc_type("MICRO_SIM");
+		  procs[i] = new_micro_proc(i, new mmu_t(mem, memsz, MICRO_MMU));
     }
+		procs[i]->get_mmu()->set_dirty_pages(dirty_pages);
 	}
 
 }
 
+// A timing simulator core, built with the current parameters.
+processor_t* sim_t::new_micro_proc(size_t i, mmu_t* mmu)
+{
+  processor_t* p = new pipeline_t(
+      this,
+      mmu,
+      i,
+      FETCH_QUEUE_SIZE,
+      NUM_CHECKPOINTS,
+      ACTIVE_LIST_SIZE,
+      (AUTO_PRF_SIZE ? (NXPR + NFPR + ACTIVE_LIST_SIZE) : PRF_SIZE),
+      ISSUE_QUEUE_SIZE,
+      ISSUE_QUEUE_NUM_PARTS,
+      LQ_SIZE,
+      SQ_SIZE,
+      FETCH_WIDTH,
+      DISPATCH_WIDTH,
+      ISSUE_WIDTH,
+      RETIRE_WIDTH,
+      FU_LANE_MATRIX,
+      FU_LAT);
+  p->set_proc_type("MICRO_SIM");
+  return p;
+}
+
+// Replaces the timing simulator's cores with new ones, built with the
+// current parameters, in the same architectural state: e.g., in each child
+// of a configuration sweep, after the skip or restore. The old cores are
+// left alone, as deleting them would dump their (empty) stats into the
+// stats log opened by the parent.
+void sim_t::rebuild_procs()
+{
+  assert(proc_type == MICRO_SIM);
+  for (size_t i = 0; i < procs.size(); i++) {
+    processor_t* old = procs[i];
+    processor_t* p = new_micro_proc(i, old->get_mmu());
+    p->reset(!old->running());
+    p->state = old->state;
+    p->set_debug(old->get_debug());
+    p->set_checker(old->get_checker());
+    p->set_histogram(histogram_enabled);
+    p->set_pipe(old->get_pipe());
+    p->get_mmu()->set_processor(p);
+    procs[i] = p;
+    ((pipeline_t*)p)->copy_state_to_micro();
+  }
+}
+
 sim_t::~sim_t()
 {
 	for (size_t i = 0; i < procs.size(); i++)
@@ -94,8 +155,12 @@ sim_t::~sim_t()
 		delete procs[i];
 		delete pmmu;
 	}
+	finish_checkpoints();
 	delete debug_mmu;
-	free(mem);
+	delete dirty_pages;
+	munmap(mem, memsz);
+	if (mem_image_fd >= 0)
+		close(mem_image_fd);
 }
 
 void sim_t::send_ipi(reg_t who)
@@ -127,11 +192,14 @@ void sim_t::boot()
 
 int sim_t::run() {
    bool htif_return = true;
-   while (htif_return) {
+   while (htif_return && !end_requested) {
       if (debug || ctrlc_pressed)
          interactive();
-      else
+      else {
          htif_return = step();
+         if (htif_return && snapshot_interval && (((pipeline_t*)procs[0])->cycle >= next_snapshot))
+            write_snapshot();
+      }
    }
    return htif->exit_code();
 }
@@ -172,8 +240,10 @@ bool sim_t::step() {
       if (++current_proc == procs.size())
          current_proc = 0;
 
-      // If HTIF is done, this will return false
-      htif_return = htif->tick();
+      // If HTIF is done, this will return false.
+      // Ticks that can only be no-ops are skipped (see htif_isasim_t::needs_tick()).
+      if (htif->needs_tick())
+         htif_return = htif->tick();
    }
 
    return htif_return;
@@ -186,6 +256,9 @@ bool sim_t::run_fast(size_t n)
   bool old_checker = get_procs_checker();
   //set_procs_debug(true);
   set_procs_checker(false);
+  // Functional warming of the timing simulator's caches and branch predictors.
+  if(proc_type == MICRO_SIM)
+    set_procs_warming(FUNCTIONAL_WARMING);
 
   bool htif_return = true;
   size_t total_retired = 0;
@@ -221,7 +294,8 @@ bool sim_t::run_fast(size_t n)
 			}
 
       // If HTIF is done, this will return false
-			htif_return = htif->tick();
+      if (htif->needs_tick())
+			  htif_return = htif->tick();
 		}
 	}
 
@@ -237,9 +311,115 @@ bool sim_t::run_fast(size_t n)
 
   set_procs_debug(old_debug);
   set_procs_checker(old_checker);
+  set_procs_warming(false);
   return htif_return;
 }
 
+// Steps the timing simulator until at least 'n' more instructions retire.
+bool sim_t::run_detailed(uint64_t n)
+{
+  pipeline_t* p = (pipeline_t*)procs[current_proc];
+  uint64_t end = p->num_insn + n;
+  bool htif_return = true;
+  while (htif_return && (p->num_insn < end) && !end_requested)
+    htif_return = step();
+  return htif_return;
+}
+
+// SMARTS-style systematic sampling: of every SAMPLE_PERIOD instructions,
+// SAMPLE_WARMUP instructions warm up the timing simulator, the next
+// SAMPLE_UNIT instructions are measured, and the rest are fast skipped
+// (by the ISA simulator too, if there is one). Sampling goes on until the
+// program ends, or until the mean CPI is known within SAMPLE_ERROR at
+// SAMPLE_CONFIDENCE, after at least SAMPLE_MIN_UNITS units. The CPI of
+// each unit and the estimate are written to stats.log. With
+// FUNCTIONAL_WARMING, the fast skips also warm the caches and predictors.
+#define SAMPLE_MIN_UNITS  30
+#define SAMPLE_CONFIDENCE "99.7"
+#define SAMPLE_Z          3.0
+
+int sim_t::run_sampled()
+{
+  pipeline_t* p = (pipeline_t*)procs[current_proc];
+  debug_buffer_t* db = p->get_pipe();
+  uint64_t skip = SAMPLE_PERIOD - std::min(SAMPLE_PERIOD, SAMPLE_WARMUP + SAMPLE_UNIT);
+  std::vector<std::pair<uint64_t, double> > units;	// (first instruction, CPI)
+  FILE* warmup = tmpfile();	// measurements from before the current warmup
+  uint64_t instret = 0;
+  double sum = 0, sum2 = 0, mean = 0, stddev = 0, error = 0;
+
+  if (!warmup) {
+    perror("sampling");
+    exit(-1);
+  }
+
+  // Nothing has been fetched yet.
+  p->retire_next_pc = p->FetchUnit->getPC();
+
+  bool htif_return = true;
+  while (htif_return) {
+    p->copy_state_from_micro();
+    if (db)
+      db->skip(skip);
+    htif_return = run_fast(skip);
+    instret += skip;
+
+    // Measurements (counters, histograms, and the fetch unit's, LSU's and
+    // caches' own) only cover the measured units, not the detailed warmup.
+    uint64_t start = p->num_insn;
+    rewind(warmup);
+    snapshot_t before(warmup, true);
+    p->measurements(before);
+    fflush(warmup);
+    htif_return = htif_return && run_detailed(SAMPLE_WARMUP);
+    rewind(warmup);
+    snapshot_t after(warmup, false);
+    p->measurements(after);
+    cycle_t unit_cycle = p->cycle;
+    uint64_t unit_insn = p->num_insn;
+    htif_return = htif_return && run_detailed(SAMPLE_UNIT);
+    if (!htif_return || end_requested)
+      break;	// The program ended (or -e was reached, or the run was interrupted) before the end of the unit.
+
+    units.push_back(std::make_pair(instret + (unit_insn - start),
+                                   (double)(p->cycle - unit_cycle) / (p->num_insn - unit_insn)));
+    instret += p->num_insn - start;
+
+    double n = units.size();
+    sum += units.back().second;
+    sum2 += units.back().second * units.back().second;
+    mean = sum / n;
+    stddev = ((n > 1) ? std::sqrt(std::max(0.0, (sum2 - n * mean * mean) / (n - 1))) : 0.0);
+    error = ((n > 1) ? SAMPLE_Z * stddev / std::sqrt(n) / mean : INFINITY);
+    if ((units.size() >= SAMPLE_MIN_UNITS) && (error <= SAMPLE_ERROR))
+      break;
+  }
+
+  fprintf(stderr, "Sampling: %lu units, CPI %.4f +/- %.2f%% (%s%% confidence)%s\n", units.size(), mean,
+          100 * error, SAMPLE_CONFIDENCE, (htif_return ? ", stopped early" : ""));
+
+  FILE* log = p->stats_log;
+  fprintf(log, "[sampling]\n");
+  fprintf(log, "sample_period : %lu\n", SAMPLE_PERIOD);
+  fprintf(log, "sample_unit : %lu\n", SAMPLE_UNIT);
+  fprintf(log, "sample_warmup : %lu\n", SAMPLE_WARMUP);
+  fprintf(log, "sample_functional_warming : %d\n", (int)FUNCTIONAL_WARMING);
+  fprintf(log, "sample_units : %lu\n", units.size());
+  fprintf(log, "sample_instructions : %lu\n", instret);
+  fprintf(log, "sample_stopped_early : %d\n", (int)htif_return);
+  fprintf(log, "cpi_mean : %.4f\n", mean);
+  fprintf(log, "cpi_stddev : %.4f\n", stddev);
+  fprintf(log, "cpi_confidence_interval_" SAMPLE_CONFIDENCE " : %.4f - %.4f\n", mean * (1 - error), mean * (1 + error));
+  fprintf(log, "cpi_error : %.2f%%\n", 100 * error);
+  fprintf(log, "ipc_estimate : %.4f\n", (mean ? 1 / mean : 0.0));
+  fprintf(log, "-------Sampled Units (instruction CPI)-------\n");
+  for (size_t i = 0; i < units.size(); i++)
+    fprintf(log, "%lu %.4f\n", units[i].first, units[i].second);
+
+  fclose(warmup);
+  return htif->exit_code();
+}
+
 void sim_t::step_till_pc(reg_t break_pc,unsigned int proc_n)
 {
   procs[proc_n]->set_debug(true);
@@ -289,66 +469,498 @@ void sim_t::set_simpoint(bool enable, size_t interval)
     procs[i]->set_simpoint(enable, interval);
   }
 }
+
+// Picks simulation points from the basic block vectors profiled on core 0
+// (see pick_simpoints() in simpoint.h), and writes them in the SimPoint
+// tool's output format to simpoint.simpoints and simpoint.weights.
+void sim_t::pick_simpoints(size_t max_k)
+{
+  bb_tracker_t* bbt = procs[0]->get_bb_tracker();
+  bbt->finish();
+  std::vector<simpoint_t> simpoints = ::pick_simpoints(bbt->get_intervals(), max_k);
+
+  FILE* fs = fopen("simpoint.simpoints", "w");
+  FILE* fw = fopen("simpoint.weights", "w");
+  if (!fs || !fw) {
+    perror("simpoint");
+    exit(-1);
+  }
+  uint64_t interval = bbt->get_interval_size();
+  fprintf(stderr, "SimPoint: %lu simulation points, from %lu intervals of %lu instructions\n",
+          simpoints.size(), bbt->get_intervals().size(), interval);
+  for (size_t i = 0; i < simpoints.size(); i++) {
+    fprintf(fs, "%lu %lu\n", simpoints[i].interval, simpoints[i].cluster);
+    fprintf(fw, "%f %lu\n", simpoints[i].weight, simpoints[i].cluster);
+    fprintf(stderr, "  interval %lu (-s%lu -e%lu): weight %.4f\n", simpoints[i].interval,
+            simpoints[i].interval * interval, interval, simpoints[i].weight);
+  }
+  fclose(fs);
+  fclose(fw);
+}
 #endif
 
-void sim_t::init_checkpoint(std::string checkpoint_file)
+/////////////////////////////////////////////////////////////////////
+// Checkpoints.
+//
+// A checkpoint file (version 2) holds:
+// 1. checkpoint_header_t (version 1: up to data_offset; always uncompressed)
+// 2. HTIF log: the HTIF transactions (text) between init_checkpoint() and
+//    create_checkpoint(), replayed by htif_isasim_t::restore_checkpoint().
+// 3. Registers: text lines "<name> <hex value>" (see CHECKPOINT_CSRS).
+// 4. Page index: the numbers of the checkpointed target pages (uint64_t),
+//    ascending. Only nonzero pages are checkpointed.
+// 5. Page data, starting at a PGSIZE-aligned offset, so runs of pages can
+//    be mapped straight from the file into target memory.
+//    Or, if the checkpoint is compressed (CHECKPOINT_COMPRESS), the pages
+//    in blocks of block_pages index entries, each block an independent
+//    zlib stream, followed by the block table (checkpoint_block_t).
+//    Blocks are compressed and decompressed by CHECKPOINT_THREADS threads;
+//    a block is inflated straight into its pages of target memory.
+//
+// Legacy gzip checkpoints (full memory image and raw state_t) can still be
+// restored.
+/////////////////////////////////////////////////////////////////////
+
+#define CHECKPOINT_MAGIC   "721CKPT"
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_VERSION_UNCOMPRESSED 1
+
+struct checkpoint_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t page_size;
+  uint64_t memsz;
+  uint64_t htif_offset;
+  uint64_t htif_size;
+  uint64_t regs_offset;
+  uint64_t regs_size;
+  uint64_t index_offset;
+  uint64_t npages;
+  uint64_t data_offset;
+  // Version 2 and later.
+  uint64_t block_pages;		// 0: uncompressed
+  uint64_t blocks_offset;
+  uint64_t nblocks;
+};
+
+struct checkpoint_block_t {
+  uint64_t offset;
+  uint64_t size;
+};
+
+// Compressed checkpoints: pages per block (1MB), and zlib level.
+#define CHECKPOINT_BLOCK_PAGES ((1 << 20) / PGSIZE)
+#define CHECKPOINT_ZLIB_LEVEL  Z_BEST_SPEED
+
+// Control and status registers in the register section, besides x<n>, f<n>.
+#define CHECKPOINT_CSRS(X) \
+  X(pc) X(epc) X(badvaddr) X(evec) X(ptbr) X(pcr_k0) X(pcr_k1) X(cause) \
+  X(tohost) X(fromhost) X(count) X(compare) X(sr) X(fflags) X(frm) \
+  X(load_reservation)
+
+// Restoring maps runs of pages from the file, up to this many runs.
+// Beyond that, pages are read instead (each mapping costs a VMA).
+#define CHECKPOINT_MAX_MAPPED_RUNS 4096
+
+static void checkpoint_io_error(const std::string& file)
 {
-  // Check if file name has .gz extension. If not, append .gz to the name
-  if(checkpoint_file.substr(checkpoint_file.find_last_of(".") + 1) != "gz") {
-    checkpoint_file = checkpoint_file+".gz";
+  std::cerr << "ERROR: checkpoint `" << file << "': " << strerror(errno) << "\n";
+  exit(-1);
+}
+
+static void pread_all(int fd, void* buf, size_t size, uint64_t offset, const std::string& file)
+{
+  for (size_t done = 0; done < size; ) {
+    ssize_t n = pread(fd, (char*)buf + done, size - done, offset + done);
+    if (n <= 0) {
+      if (n == 0)
+        errno = EIO;
+      checkpoint_io_error(file);
+    }
+    done += n;
+  }
+}
+
+static unsigned checkpoint_threads(size_t nblocks)
+{
+  size_t threads = (CHECKPOINT_THREADS ? CHECKPOINT_THREADS : std::thread::hardware_concurrency());
+  return std::max((size_t)1, std::min(threads, nblocks));
+}
+
+// Compress the given pages in blocks on a pool of threads, writing the
+// blocks to 'fp' in order as they complete. 'offset' is the file offset
+// of the first block. Fills in the block table.
+static bool write_compressed_blocks(FILE* fp, uint64_t offset, const std::vector<const char*>& pages,
+                                    std::vector<checkpoint_block_t>& table)
+{
+  size_t nblocks = table.size();
+  unsigned threads = checkpoint_threads(nblocks);
+  size_t window = 4 * threads;	// bounds the compressed blocks waiting to be written
+  std::vector<std::vector<Bytef> > data(nblocks);
+  std::vector<bool> done(nblocks, false);
+  size_t next = 0, written = 0;
+  bool ok = true;
+  std::mutex m;
+  std::condition_variable cv;
+
+  auto worker = [&]() {
+    while (true) {
+      size_t b;
+      {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&]{ return (next >= nblocks) || (next < written + window); });
+        if (next >= nblocks)
+          return;
+        b = next++;
+      }
+
+      size_t first = b * CHECKPOINT_BLOCK_PAGES;
+      size_t n = std::min((size_t)CHECKPOINT_BLOCK_PAGES, pages.size() - first);
+      std::vector<Bytef> out(compressBound(n * PGSIZE));
+      z_stream z;
+      memset(&z, 0, sizeof(z));
+      bool block_ok = (deflateInit(&z, CHECKPOINT_ZLIB_LEVEL) == Z_OK);
+      z.next_out = out.data();
+      z.avail_out = out.size();
+      for (size_t i = 0; block_ok && (i < n); i++) {
+        z.next_in = (Bytef*)pages[first + i];
+        z.avail_in = PGSIZE;
+        int flush = ((i + 1 == n) ? Z_FINISH : Z_NO_FLUSH);
+        block_ok = (deflate(&z, flush) == ((flush == Z_FINISH) ? Z_STREAM_END : Z_OK));
+      }
+      out.resize(z.total_out);
+      deflateEnd(&z);
+
+      std::lock_guard<std::mutex> lock(m);
+      ok = ok && block_ok;
+      data[b].swap(out);
+      done[b] = true;
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; t++)
+    pool.push_back(std::thread(worker));
+
+  for (size_t b = 0; b < nblocks; b++) {
+    std::vector<Bytef> block;
+    {
+      std::unique_lock<std::mutex> lock(m);
+      cv.wait(lock, [&]{ return done[b]; });
+      block.swap(data[b]);
+    }
+    table[b].offset = offset;
+    table[b].size = block.size();
+    offset += block.size();
+    bool write_ok = (fwrite(block.data(), 1, block.size(), fp) == block.size());
+
+    std::lock_guard<std::mutex> lock(m);
+    ok = ok && write_ok;
+    written++;
+    cv.notify_all();
   }
 
+  for (unsigned t = 0; t < threads; t++)
+    pool[t].join();
+  return ok;
+}
+
+// Inflate the blocks on a pool of threads, each straight into its pages of
+// target memory.
+static bool read_compressed_blocks(int fd, char* mem, const std::vector<uint64_t>& pages,
+                                   const std::vector<checkpoint_block_t>& table, size_t block_pages)
+{
+  std::atomic<size_t> next(0);
+  std::atomic<bool> ok(true);
+
+  auto worker = [&]() {
+    for (size_t b; (b = next++) < table.size(); ) {
+      std::vector<Bytef> in(table[b].size);
+      size_t done = 0;
+      while (done < in.size()) {
+        ssize_t n = pread(fd, in.data() + done, in.size() - done, table[b].offset + done);
+        if (n <= 0)
+          break;
+        done += n;
+      }
+
+      z_stream z;
+      memset(&z, 0, sizeof(z));
+      bool block_ok = (done == in.size()) && (inflateInit(&z) == Z_OK);
+      z.next_in = in.data();
+      z.avail_in = in.size();
+      size_t first = b * block_pages;
+      size_t n = std::min(block_pages, pages.size() - first);
+      for (size_t i = 0; block_ok && (i < n); i++) {
+        z.next_out = (Bytef*)(mem + pages[first + i] * PGSIZE);
+        z.avail_out = PGSIZE;
+        int ret = inflate(&z, Z_SYNC_FLUSH);
+        block_ok = (z.avail_out == 0) && (ret == ((i + 1 == n) ? Z_STREAM_END : Z_OK));
+      }
+      inflateEnd(&z);
+      if (!block_ok)
+        ok = false;
+    }
+  };
+
+  unsigned threads = checkpoint_threads(table.size());
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; t++)
+    pool.push_back(std::thread(worker));
+  worker();
+  for (size_t t = 0; t < pool.size(); t++)
+    pool[t].join();
+  return ok;
+}
+
+void sim_t::init_checkpoint(std::string checkpoint_file)
+{
   checkpointing_enabled = true; 
   this->checkpoint_file = checkpoint_file;
-  proc_chkpt.open(checkpoint_file.c_str(), std::ios::out | std::ios::binary);
-  if ( ! proc_chkpt.good()) {
-    std::cerr << "ERROR: Opening file `" << checkpoint_file << "' failed.\n";
-    exit(0);
-  }
-  htif->start_checkpointing(proc_chkpt);
+  htif_chkpt.str("");
+  htif->start_checkpointing(htif_chkpt);
 }
 
-bool sim_t::create_checkpoint()
+// A checkpoint's contents, captured by capture_checkpoint() and written
+// (possibly on the checkpoint writer thread) by write_checkpoint().
+struct checkpoint_snapshot_t {
+  std::string file;
+  uint64_t memsz;
+  std::string htif_log;
+  std::string regs;
+  std::vector<uint64_t> pages;		// nonzero pages, ascending
+  std::vector<const char*> data;	// their contents (in target memory, or in 'copy')
+  std::vector<char> copy;
+};
+
+static void write_checkpoint(const checkpoint_snapshot_t& snap)
 {
-  bool htif_return = true;
+  checkpoint_header_t hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  strcpy(hdr.magic, CHECKPOINT_MAGIC);
+  hdr.version = CHECKPOINT_VERSION;
+  hdr.page_size = PGSIZE;
+  hdr.memsz = snap.memsz;
+  hdr.htif_offset = sizeof(hdr);
+  hdr.htif_size = snap.htif_log.size();
+  hdr.regs_offset = hdr.htif_offset + hdr.htif_size;
+  hdr.regs_size = snap.regs.size();
+  hdr.index_offset = hdr.regs_offset + hdr.regs_size;
+  hdr.npages = snap.pages.size();
+  hdr.data_offset = (hdr.index_offset + hdr.npages * sizeof(uint64_t) + PGSIZE - 1) / PGSIZE * PGSIZE;
+  if (CHECKPOINT_COMPRESS) {
+    hdr.block_pages = CHECKPOINT_BLOCK_PAGES;
+    hdr.nblocks = (hdr.npages + hdr.block_pages - 1) / hdr.block_pages;
+  }
 
-  htif->stop_checkpointing();
-  fprintf(stderr,"Checkpointed HTIF state\n");
-  fflush(0);
+  FILE* fp = fopen(snap.file.c_str(), "wb");
+  if (!fp)
+    checkpoint_io_error(snap.file);
+  std::vector<char> pad(hdr.data_offset - (hdr.index_offset + hdr.npages * sizeof(uint64_t)), 0);
+  bool ok = (fwrite(&hdr, sizeof(hdr), 1, fp) == 1) &&
+            (fwrite(snap.htif_log.data(), 1, snap.htif_log.size(), fp) == snap.htif_log.size()) &&
+            (fwrite(snap.regs.data(), 1, snap.regs.size(), fp) == snap.regs.size()) &&
+            (fwrite(snap.pages.data(), sizeof(uint64_t), snap.pages.size(), fp) == snap.pages.size()) &&
+            (fwrite(pad.data(), 1, pad.size(), fp) == pad.size());
+  if (hdr.block_pages) {
+    std::vector<checkpoint_block_t> table(hdr.nblocks);
+    ok = ok && write_compressed_blocks(fp, hdr.data_offset, snap.data, table);
+    hdr.blocks_offset = (table.empty() ? hdr.data_offset : table.back().offset + table.back().size);
+    ok = ok && (fwrite(table.data(), sizeof(checkpoint_block_t), table.size(), fp) == table.size()) &&
+         (fseek(fp, 0, SEEK_SET) == 0) && (fwrite(&hdr, sizeof(hdr), 1, fp) == 1);
+  }
+  else {
+    for (size_t i = 0; ok && (i < snap.data.size()); i++)
+      ok = (fwrite(snap.data[i], PGSIZE, 1, fp) == 1);
+  }
+  if (!ok || (fclose(fp) != 0))
+    checkpoint_io_error(snap.file);
 
-  create_memory_checkpoint(proc_chkpt);
-  fprintf(stderr,"Checkpointed memory state\n");
-  fflush(0);
+  fprintf(stderr, "Created processor checkpoint to %s (%lu pages)\n", snap.file.c_str(), snap.pages.size());
+}
 
-  create_register_checkpoint(proc_chkpt);
-  fprintf(stderr,"Checkpointed register state\n");
-  fflush(0);
+// Writes queued checkpoints on a background thread, so that the simulation
+// can run on while they are compressed and written. At most
+// CHECKPOINT_MAX_PENDING checkpoints (including the one being written) are
+// held in memory; queueing another waits for the writer.
+#define CHECKPOINT_MAX_PENDING 2
+
+class checkpoint_writer_t {
+public:
+  checkpoint_writer_t() : stopping(false), thread(&checkpoint_writer_t::main, this) {}
+
+  ~checkpoint_writer_t()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+  }
 
-  proc_chkpt.close();
-  std::cerr << "Created processor checkpoint to " << checkpoint_file << std::endl;
-  return htif_return;
+  void push(checkpoint_snapshot_t* snap)
+  {
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [&]{ return queue.size() < CHECKPOINT_MAX_PENDING; });
+    queue.push_back(snap);
+    cv.notify_all();
+  }
+
+private:
+  std::mutex m;
+  std::condition_variable cv;
+  std::deque<checkpoint_snapshot_t*> queue;
+  bool stopping;
+  std::thread thread;
+
+  void main()
+  {
+    while (true) {
+      checkpoint_snapshot_t* snap;
+      {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&]{ return stopping || !queue.empty(); });
+        if (queue.empty())
+          return;
+        snap = queue.front();
+      }
+      write_checkpoint(*snap);
+      delete snap;
+
+      std::lock_guard<std::mutex> lock(m);
+      queue.pop_front();
+      cv.notify_all();
+    }
+  }
+};
+
+// The HTIF log of a checkpoint is everything logged since init_checkpoint();
+// logging goes on, so later checkpoints of the same run can be taken.
+// If 'copy' is set, the pages are copied, so that the simulation can run on
+// before the checkpoint is written.
+void sim_t::capture_checkpoint(checkpoint_snapshot_t& snap, bool copy)
+{
+  snap.memsz = memsz;
+  snap.htif_log = htif_chkpt.str() + "END_HTIF_CHECKPOINT 0 0 0\n";
+  snap.regs = register_checkpoint();
+
+  // Only pages that have been written can be nonzero.
+  for (size_t page = 0; page < dirty_pages->size(); page++) {
+    if (dirty_pages->test(page)) {
+      const uint64_t* p = (const uint64_t*)(mem + page * PGSIZE);
+      size_t i = 0;
+      while ((i < PGSIZE/sizeof(uint64_t)) && (p[i] == 0))
+        i++;
+      if (i < PGSIZE/sizeof(uint64_t))
+        snap.pages.push_back(page);
+    }
+  }
+
+  if (copy)
+    snap.copy.resize(snap.pages.size() * PGSIZE);
+  for (size_t i = 0; i < snap.pages.size(); i++) {
+    const char* page = mem + snap.pages[i] * PGSIZE;
+    if (copy) {
+      memcpy(&snap.copy[i * PGSIZE], page, PGSIZE);
+      page = &snap.copy[i * PGSIZE];
+    }
+    snap.data.push_back(page);
+  }
+}
+
+bool sim_t::create_checkpoint()
+{
+  checkpoint_snapshot_t snap;
+  snap.file = checkpoint_file;
+  capture_checkpoint(snap, false);
+  write_checkpoint(snap);
+  return true;
 }
 
-void sim_t::create_memory_checkpoint(std::ostream& memory_chkpt)
+void sim_t::queue_checkpoint(const std::string& file)
 {
-  uint64_t signature = 0xbaadbeefdeadbeef;
-  memory_chkpt.write((char*)&signature,8);
-  memory_chkpt.write((char*)&memsz,sizeof(memsz));
-  memory_chkpt.write(mem,memsz);
+  checkpoint_snapshot_t* snap = new checkpoint_snapshot_t;
+  snap->file = file;
+  capture_checkpoint(*snap, true);
+  if (!chkpt_writer)
+    chkpt_writer = new checkpoint_writer_t;
+  chkpt_writer->push(snap);
 }
 
-void sim_t::create_register_checkpoint(std::ostream& proc_chkpt)
+void sim_t::finish_checkpoints()
+{
+  delete chkpt_writer;
+  chkpt_writer = NULL;
+}
+
+std::string sim_t::register_checkpoint()
 {
   state_t *state = procs[current_proc]->get_state();
-  uint64_t signature = 0xdeadbeefbaadbeef;
-  proc_chkpt.write((char*)&signature,8);
-  proc_chkpt.write((char *)state,sizeof(state_t));
+  std::ostringstream regs;
+  regs << std::hex;
+  #define CHECKPOINT_PUT_CSR(name) regs << #name " " << (reg_t)state->name << "\n";
+  CHECKPOINT_CSRS(CHECKPOINT_PUT_CSR)
+  #undef CHECKPOINT_PUT_CSR
+  for (size_t i = 0; i < NXPR; i++)
+    regs << "x" << std::dec << i << std::hex << " " << state->XPR[i] << "\n";
+  for (size_t i = 0; i < NFPR; i++)
+    regs << "f" << std::dec << i << std::hex << " " << state->FPR[i] << "\n";
+  return regs.str();
 }
 
-bool sim_t::restore_checkpoint(std::string restore_file)
+void sim_t::restore_register_checkpoint(const std::string& regs)
+{
+  state_t *state = procs[0]->get_state();
+  state->reset();
+
+  std::istringstream in(regs);
+  std::string name;
+  reg_t value;
+  while (in >> name >> std::hex >> value) {
+    #define CHECKPOINT_GET_CSR(csr) if (name == #csr) { state->csr = value; continue; }
+    CHECKPOINT_CSRS(CHECKPOINT_GET_CSR)
+    #undef CHECKPOINT_GET_CSR
+    if ((name[0] == 'x') && (atoi(name.c_str() + 1) < NXPR))
+      state->XPR.write(atoi(name.c_str() + 1), value);
+    else if ((name[0] == 'f') && (atoi(name.c_str() + 1) < NFPR))
+      state->FPR.write(atoi(name.c_str() + 1), value);
+    else
+      fprintf(stderr, "warning: unknown register `%s' in checkpoint\n", name.c_str());
+  }
+  restored_proc_state();
+}
+
+// If 'share' is given, it has already restored the same checkpoint (and not
+// run since). A legacy checkpoint is then only read for its HTIF state: the
+// memory image is shared with 'share' (see share_memory_image()) and the
+// register state is copied from it. Versioned checkpoints are cheap to
+// restore twice: their pages are mapped, so both simulators share them in
+// the page cache.
+bool sim_t::restore_checkpoint(std::string restore_file, sim_t* share)
 {
   bool htif_return = true;
 
+  // The header is read by version: a version 1 header ends before block_pages.
+  checkpoint_header_t hdr;
+  const size_t v1_size = offsetof(checkpoint_header_t, block_pages);
+  memset(&hdr, 0, sizeof(hdr));
+  int fd = open(restore_file.c_str(), O_RDONLY);
+  if ((fd >= 0) && (pread(fd, &hdr, v1_size, 0) == (ssize_t)v1_size) && !strcmp(hdr.magic, CHECKPOINT_MAGIC)) {
+    if ((hdr.version != CHECKPOINT_VERSION_UNCOMPRESSED) &&
+        (pread(fd, (char *)&hdr + v1_size, sizeof(hdr) - v1_size, v1_size) != (ssize_t)(sizeof(hdr) - v1_size))) {
+      std::cerr << "ERROR: checkpoint `" << restore_file << "' has a truncated header.\n";
+      exit(-1);
+    }
+    htif_return = restore_sparse_checkpoint(fd, hdr, restore_file);
+    close(fd);
+    return htif_return;
+  }
+  if (fd >= 0)
+    close(fd);
+
+  // Legacy gzip checkpoint.
   // Check if file name has .gz extension. If not, append .gz to the name
   if(restore_file.substr(restore_file.find_last_of(".") + 1) != "gz") {
     restore_file = restore_file+".gz";
@@ -357,7 +969,7 @@ bool sim_t::restore_checkpoint(std::string restore_file)
   //std::cerr << "Trying to restore HTIF checkpoint from " << restore_file << std::endl;
   fflush(0);
   restore_chkpt.open (restore_file.c_str(), std::ios::in | std::ios::binary);
-  if ( ! proc_chkpt.good()) {
+  if ( ! restore_chkpt.good()) {
     std::cerr << "ERROR: Opening file `" << restore_file << "' failed.\n";
 	  return false;
   }
@@ -367,14 +979,105 @@ bool sim_t::restore_checkpoint(std::string restore_file)
   std::cerr << "Done restoring HTIF checkpoint from " << restore_file << std::endl;
 
   //std::cerr << "Trying to restore mem/reg HTIF checkpoint from " << restore_file << std::endl;
-  restore_memory_checkpoint(restore_chkpt);
-  restore_proc_checkpoint(restore_chkpt);
+  if (share) {
+    share_memory_image(share);
+    *procs[0]->get_state() = *share->procs[0]->get_state();
+    restored_proc_state();
+  }
+  else {
+    restore_memory_checkpoint(restore_chkpt);
+    restore_proc_checkpoint(restore_chkpt);
+  }
   restore_chkpt.close();
   std::cerr << "Done restoring mem/reg checkpoint from " << restore_file << std::endl;
 
   return htif_return;
 }
 
+bool sim_t::restore_sparse_checkpoint(int fd, const checkpoint_header_t& hdr, const std::string& restore_file)
+{
+  bool known_version = (hdr.version == CHECKPOINT_VERSION) || (hdr.version == CHECKPOINT_VERSION_UNCOMPRESSED);
+  if (!known_version || (hdr.page_size != PGSIZE) || (hdr.memsz != memsz)) {
+    std::cerr << "ERROR: checkpoint `" << restore_file << "' is version " << hdr.version
+              << " with " << hdr.page_size << "-byte pages and " << hdr.memsz << " bytes of memory; expected version "
+              << CHECKPOINT_VERSION_UNCOMPRESSED << " or " << CHECKPOINT_VERSION << ", " << PGSIZE << ", " << memsz << ".\n";
+    exit(-1);
+  }
+
+  // When syscalls are replayed from a log, the host needs no state from
+  // before the checkpoint: the logged syscalls up to the checkpoint are
+  // skipped instead (below).
+  bool htif_return = true;
+  if (!htif->replaying_syscalls()) {
+    std::string htif_log(hdr.htif_size, '\0');
+    pread_all(fd, &htif_log[0], hdr.htif_size, hdr.htif_offset, restore_file);
+    std::istringstream htif_in(htif_log);
+    htif_return = htif->restore_checkpoint(htif_in);
+  }
+
+  // Start from all-zero memory, then bring in the checkpointed pages.
+  if (mmap(mem, memsz, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED|MAP_NORESERVE, -1, 0) != mem)
+    checkpoint_io_error(restore_file);
+  dirty_pages->clear_all();
+
+  std::vector<uint64_t> pages(hdr.npages);
+  pread_all(fd, pages.data(), hdr.npages * sizeof(uint64_t), hdr.index_offset, restore_file);
+
+  size_t runs = 0;
+  for (size_t i = 0; i < pages.size(); i++) {
+    if ((pages[i] >= dirty_pages->size()) || (i && (pages[i] <= pages[i-1]))) {
+      std::cerr << "ERROR: checkpoint `" << restore_file << "' has a bad page index.\n";
+      exit(-1);
+    }
+    if (!i || (pages[i] != pages[i-1] + 1))
+      runs++;
+  }
+  bool map = !hdr.block_pages && (runs <= CHECKPOINT_MAX_MAPPED_RUNS) && ((PGSIZE % sysconf(_SC_PAGESIZE)) == 0);
+
+  if (hdr.block_pages) {
+    std::vector<checkpoint_block_t> table(hdr.nblocks);
+    if (hdr.nblocks != (hdr.npages + hdr.block_pages - 1) / hdr.block_pages) {
+      std::cerr << "ERROR: checkpoint `" << restore_file << "' has a bad block table.\n";
+      exit(-1);
+    }
+    pread_all(fd, table.data(), hdr.nblocks * sizeof(checkpoint_block_t), hdr.blocks_offset, restore_file);
+    bool ok = true;
+    for (size_t b = 0; b < table.size(); b++)
+      ok = ok && (table[b].size <= compressBound(hdr.block_pages * PGSIZE));
+    if (!ok || !read_compressed_blocks(fd, mem, pages, table, hdr.block_pages)) {
+      std::cerr << "ERROR: checkpoint `" << restore_file << "' has a corrupt compressed block.\n";
+      exit(-1);
+    }
+  }
+
+  for (size_t i = 0; i < pages.size(); ) {
+    size_t n = 1;
+    while ((i + n < pages.size()) && (pages[i+n] == pages[i] + n))
+      n++;
+
+    char* dst = mem + pages[i] * PGSIZE;
+    uint64_t offset = hdr.data_offset + i * PGSIZE;
+    if (map) {
+      if (mmap(dst, n * PGSIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED|MAP_NORESERVE, fd, offset) != dst)
+        checkpoint_io_error(restore_file);
+    }
+    else if (!hdr.block_pages)
+      pread_all(fd, dst, n * PGSIZE, offset, restore_file);
+
+    dirty_pages->set_range(pages[i] * PGSIZE, n * PGSIZE);
+    i += n;
+  }
+  flush_mmus();
+
+  std::string regs(hdr.regs_size, '\0');
+  pread_all(fd, &regs[0], hdr.regs_size, hdr.regs_offset, restore_file);
+  restore_register_checkpoint(regs);
+  htif->skip_replayed_syscalls(procs[0]->get_state()->count);
+
+  std::cerr << "Done restoring checkpoint from " << restore_file << " (" << hdr.npages << " pages)" << std::endl;
+  return htif_return;
+}
+
 void sim_t::restore_memory_checkpoint(std::istream& memory_chkpt)
 {
   uint64_t signature;
@@ -384,7 +1087,75 @@ void sim_t::restore_memory_checkpoint(std::istream& memory_chkpt)
   // Check that the checkpointed memory size the current simulator memory size are same
   memory_chkpt.read((char*)&chkpt_memsz,sizeof(chkpt_memsz));
   assert(memsz == chkpt_memsz);
-  memory_chkpt.read(mem,memsz);
+
+  // Build an image holding only the nonzero pages, in a memory file that
+  // is then mapped copy-on-write over the target memory. This keeps the
+  // restored memory sparse, and another simulator restoring the same
+  // checkpoint maps the image instead of reading it again.
+  mem_image_fd = memfd_create("721sim-mem", 0);
+  if ((mem_image_fd < 0) || (ftruncate(mem_image_fd, memsz) != 0)) {
+    perror("memory image");
+    exit(-1);
+  }
+
+  const size_t CHUNK = 1 << 20;
+  std::vector<char> buf(CHUNK);
+  for (size_t pos = 0; pos < memsz; pos += CHUNK) {
+    size_t len = std::min(CHUNK, memsz - pos);
+    memory_chkpt.read(&buf[0], len);
+
+    // Write runs of nonzero pages.
+    size_t run = 0, run_len = 0;
+    for (size_t off = 0; off < len; off += PGSIZE) {
+      size_t page_len = std::min((size_t)PGSIZE, len - off);
+      const uint64_t* p = (const uint64_t*)&buf[off];
+      bool nonzero = false;
+      for (size_t i = 0; i < page_len/sizeof(uint64_t) && !nonzero; i++)
+        nonzero = (p[i] != 0);
+
+      if (nonzero) {
+        if (!run_len)
+          run = off;
+        run_len += page_len;
+        dirty_pages->set((pos + off) >> PGSHIFT);
+      }
+      if (run_len && (!nonzero || (off + page_len == len))) {
+        if (pwrite(mem_image_fd, &buf[run], run_len, pos + run) != (ssize_t)run_len) {
+          perror("memory image");
+          exit(-1);
+        }
+        run_len = 0;
+      }
+    }
+  }
+
+  map_memory_image(mem_image_fd);
+}
+
+// Map the memory image in 'from' (restored from a checkpoint) copy-on-write,
+// as target memory. Only the pages either simulator writes get duplicated.
+void sim_t::share_memory_image(sim_t* from)
+{
+  assert((from->mem_image_fd >= 0) && (from->memsz == memsz));
+  map_memory_image(from->mem_image_fd);
+  *dirty_pages = *from->dirty_pages;
+}
+
+void sim_t::map_memory_image(int fd)
+{
+  if (mmap(mem, memsz, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED|MAP_NORESERVE, fd, 0) != mem) {
+    perror("memory image");
+    exit(-1);
+  }
+  flush_mmus();
+}
+
+// The MMUs point into target memory by address, but may have cached old contents.
+void sim_t::flush_mmus()
+{
+  debug_mmu->flush_tlb();
+  for (size_t i = 0; i < procs.size(); i++)
+    procs[i]->get_mmu()->flush_tlb();
 }
 
 void sim_t::restore_proc_checkpoint(std::istream& proc_chkpt)
@@ -394,7 +1165,11 @@ void sim_t::restore_proc_checkpoint(std::istream& proc_chkpt)
   proc_chkpt.read((char*)&signature,8);
   assert(signature == 0xdeadbeefbaadbeef);
   proc_chkpt.read((char *)state,sizeof(state_t));
+  restored_proc_state();
+}
 
+void sim_t::restored_proc_state()
+{
   // Copy registers from fast skip state to pipeline register file.
   // Also reset the AMT.
   if(proc_type == MICRO_SIM){
@@ -406,6 +1181,176 @@ void sim_t::restore_proc_checkpoint(std::istream& proc_chkpt)
   //procs[current_proc]->get_state()->dump(stderr);
 }
 
+/////////////////////////////////////////////////////////////////////
+// Timing snapshots.
+//
+// A snapshot directory holds:
+// - chkpt: checkpoint of the timing simulator (memory as retired so far,
+//   HTIF log),
+// - chkpt.isa: checkpoint of the ISA checker simulator, which runs ahead
+//   of the timing simulator (if there is one),
+// - timing: header (timing_snapshot_header_t), then the state saved by
+//   sim_t::snapshot(): the timing simulator's processor state and every
+//   pipeline structure, the debug buffer, and the ISA simulator's
+//   processor state.
+//
+// Resuming restores the two checkpoints, then the timing state on top. The
+// timing state is raw host data: a snapshot resumes only in the same build,
+// with the same timing configuration (checked) and the same checker setup
+// (--no-checker, --isathread).
+/////////////////////////////////////////////////////////////////////
+
+#define TIMING_SNAPSHOT_MAGIC   "721SNAP"
+#define TIMING_SNAPSHOT_VERSION 3
+
+struct timing_snapshot_header_t {
+  char magic[8];
+  uint64_t version;
+};
+
+static void snapshot_io_error(const std::string& path)
+{
+  std::cerr << "ERROR: timing snapshot `" << path << "': " << strerror(errno) << "\n";
+  exit(-1);
+}
+
+// Removes a snapshot directory, if it exists.
+static void remove_snapshot_dir(const std::string& dir)
+{
+  static const char* files[] = {"chkpt", "chkpt.isa", "timing"};
+  for (size_t i = 0; i < sizeof(files)/sizeof(files[0]); i++)
+    if ((unlink((dir + "/" + files[i]).c_str()) != 0) && (errno != ENOENT))
+      snapshot_io_error(dir + "/" + files[i]);
+  if ((rmdir(dir.c_str()) != 0) && (errno != ENOENT))
+    snapshot_io_error(dir);
+}
+
+void sim_t::snapshot(snapshot_t& s)
+{
+  s.check(procs.size(), "number of processors");
+  s.io(current_step);
+  s.io(current_proc);
+  s.io(idle_cycles);
+  for (size_t i = 0; i < procs.size(); i++) {
+    s.io(procs[i]->state);
+    s.io(procs[i]->run);
+    s.io(procs[i]->serialized);
+    s.io(procs[i]->rv64);
+  }
+
+  if (proc_type == MICRO_SIM) {
+    for (size_t i = 0; i < procs.size(); i++)
+      ((pipeline_t*)procs[i])->snapshot(s);
+
+    debug_buffer_t* db = procs[0]->get_pipe();
+    s.check(db != NULL, "ISA checker simulator");
+    if (db)
+      db->snapshot(s);
+  }
+}
+
+void sim_t::init_snapshots(const std::string& dir, uint64_t interval)
+{
+  assert(checkpointing_enabled);
+  snapshot_dir = dir;
+  snapshot_interval = interval;
+  cycle_t cycle = ((pipeline_t*)procs[0])->cycle;
+  next_snapshot = cycle - (cycle % interval) + interval;
+}
+
+void sim_t::write_snapshot()
+{
+  cycle_t cycle = ((pipeline_t*)procs[0])->cycle;
+  std::string tmp = snapshot_dir + ".tmp";
+  std::string old = snapshot_dir + ".old";
+
+  // The ISA simulator must hold still.
+  debug_buffer_t* db = procs[0]->get_pipe();
+  bool was_threaded = (db && db->thread_running());
+  if (db)
+    db->stop_thread();
+
+  // Once the ISA simulator has run ahead to the end of the program, its
+  // HTIF log ends with the exit and would replay it on resume: keep the
+  // previous snapshot from then on.
+  if (db && db->get_isa_sim()->htif->exited()) {
+    fprintf(stderr, "Not replacing timing snapshot %s at cycle %" PRIcycle ": the ISA simulator has reached the end of the program\n",
+            snapshot_dir.c_str(), cycle);
+    next_snapshot = UINT64_MAX;
+    if (was_threaded)
+      db->start_thread();
+    return;
+  }
+
+  remove_snapshot_dir(tmp);
+  if (mkdir(tmp.c_str(), 0777) != 0)
+    snapshot_io_error(tmp);
+
+  checkpoint_snapshot_t snap;
+  snap.file = tmp + "/chkpt";
+  capture_checkpoint(snap, false);
+  write_checkpoint(snap);
+  if (db) {
+    checkpoint_snapshot_t isa_snap;
+    isa_snap.file = tmp + "/chkpt.isa";
+    db->get_isa_sim()->capture_checkpoint(isa_snap, false);
+    write_checkpoint(isa_snap);
+  }
+
+  std::string file = tmp + "/timing";
+  FILE* fp = fopen(file.c_str(), "wb");
+  if (!fp)
+    snapshot_io_error(file);
+  timing_snapshot_header_t hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  strcpy(hdr.magic, TIMING_SNAPSHOT_MAGIC);
+  hdr.version = TIMING_SNAPSHOT_VERSION;
+  snapshot_t s(fp, true);
+  s.io(hdr);
+  snapshot(s);
+  if (fclose(fp) != 0)
+    snapshot_io_error(file);
+
+  // Replace the previous snapshot.
+  remove_snapshot_dir(old);
+  if ((rename(snapshot_dir.c_str(), old.c_str()) != 0) && (errno != ENOENT))
+    snapshot_io_error(snapshot_dir);
+  if (rename(tmp.c_str(), snapshot_dir.c_str()) != 0)
+    snapshot_io_error(snapshot_dir);
+  remove_snapshot_dir(old);
+
+  fprintf(stderr, "Wrote timing snapshot %s at cycle %" PRIcycle "\n", snapshot_dir.c_str(), cycle);
+  next_snapshot = cycle - (cycle % snapshot_interval) + snapshot_interval;
+
+  if (was_threaded)
+    db->start_thread();
+}
+
+// The checkpoints (chkpt, chkpt.isa) must have been restored already.
+void sim_t::restore_snapshot(const std::string& dir)
+{
+  std::string file = dir + "/timing";
+  FILE* fp = fopen(file.c_str(), "rb");
+  if (!fp)
+    snapshot_io_error(file);
+  timing_snapshot_header_t hdr;
+  snapshot_t s(fp, false);
+  s.io(hdr);
+  if (strncmp(hdr.magic, TIMING_SNAPSHOT_MAGIC, sizeof(hdr.magic)) || (hdr.version != TIMING_SNAPSHOT_VERSION)) {
+    std::cerr << "ERROR: `" << file << "' is not a version " << TIMING_SNAPSHOT_VERSION << " timing snapshot.\n";
+    exit(-1);
+  }
+  snapshot(s);
+  if (fgetc(fp) != EOF) {
+    std::cerr << "ERROR: timing snapshot `" << file << "' has trailing data.\n";
+    exit(-1);
+  }
+  fclose(fp);
+  flush_mmus();
+
+  fprintf(stderr, "Resumed timing snapshot %s at cycle %" PRIcycle "\n", dir.c_str(), ((pipeline_t*)procs[0])->cycle);
+}
+
 
 
 void sim_t::set_procs_debug(bool value)
@@ -439,6 +1384,13 @@ void sim_t::set_procs_checker(bool value)
 	}
 }
 
+void sim_t::set_procs_warming(bool value)
+{
+	for (size_t i=0; i< procs.size(); i++) {
+		procs[i]->set_warming(value);
+	}
+}
+
 bool sim_t::get_procs_checker()
 {
 	for (size_t i=0; i< procs.size(); i++) {
@@ -7,7 +7,9 @@
 #include <string>
 #include <memory>
 #include <fstream>
+#include <sstream>
 #include <gzstream.h>
+#include <csignal>
 //#include "pipeline.h"
 #include "mmu.h"
 
@@ -18,6 +20,10 @@ enum proc_type_t {ISA_SIM,MICRO_SIM};
 
 class htif_isasim_t;
 class debug_buffer_t;
+struct checkpoint_header_t;
+struct checkpoint_snapshot_t;
+class checkpoint_writer_t;
+class snapshot_t;
 
 // this class encapsulates the processors and memory in a RISC-V machine.
 class sim_t
@@ -29,12 +35,15 @@ public:
 	// run the simulation to completion
 	void boot();
 	int run();
+	int run_sampled(); // run with SMARTS-style sampling (see SAMPLE_PERIOD)
 	bool running();
 	void stop();
+	void rebuild_procs();
 	void set_debug(bool value);
 	void set_histogram(bool value);
 	void set_procs_debug(bool value);
 	void set_procs_checker(bool value);
+	void set_procs_warming(bool value);
 	bool get_procs_debug();
 	bool get_procs_checker();
 	htif_isasim_t* get_htif() {
@@ -43,6 +52,7 @@ public:
 
 #ifdef RISCV_ENABLE_SIMPOINT
   void set_simpoint(bool enable, size_t interval);
+  void pick_simpoints(size_t max_k);
 #endif
 
 	// deliver an IPI to a specific processor
@@ -56,9 +66,33 @@ public:
 		return procs.at(i);
 	}
 
+	// Pages of target memory written so far (by the target or the HTIF).
+	const page_bitmap_t& get_dirty_pages() {
+		return *dirty_pages;
+	}
+
   void init_checkpoint(std::string _checkpoint_file);
   bool create_checkpoint();
-  bool restore_checkpoint(std::string restore_file);
+  // Checkpoints the current state to 'file', without waiting for it to be
+  // written: the state is copied, and written on a background thread. The
+  // HTIF log is kept from init_checkpoint() on, so any number of
+  // checkpoints can be taken in one run. finish_checkpoints() waits for
+  // all of them to be written.
+  void queue_checkpoint(const std::string& file);
+  void finish_checkpoints();
+  bool restore_checkpoint(std::string restore_file, sim_t* share = NULL);
+
+  // Timing snapshots: the complete state of the timing simulator (and of
+  // the ISA checker simulator feeding it), from which a run resumes cycle
+  // for cycle as if it had never stopped. A snapshot is the directory
+  // 'dir': checkpoints 'chkpt' and 'chkpt.isa' of the two simulators, and
+  // the timing state 'timing'. The directory is replaced atomically, so a
+  // run killed while writing leaves the previous snapshot intact.
+  // init_snapshots() writes one every 'interval' cycles from then on
+  // (init_checkpoint() must have been called on both simulators at boot).
+  void init_snapshots(const std::string& dir, uint64_t interval);
+  void write_snapshot();
+  void restore_snapshot(const std::string& dir);
 
 
 	// read one of the system control registers
@@ -69,6 +103,7 @@ public:
   void step_till_pc(reg_t break_pc,unsigned int proc_n);
 
   bool run_fast(size_t n);
+  bool run_detailed(uint64_t n);
 
   proc_type_t get_proc_type(){return proc_type;}
 
@@ -77,6 +112,8 @@ private:
 	std::unique_ptr<htif_isasim_t> htif;
 	char* mem; // main memory
 	size_t memsz; // memory size in bytes
+	page_bitmap_t* dirty_pages; // pages written so far
+	int mem_image_fd; // memory image restored from a checkpoint (-1: none)
 	mmu_t* debug_mmu;  // debug port into main memory
 	std::vector<processor_t*> procs;
 
@@ -89,6 +126,10 @@ private:
 	bool histogram_enabled; // provide a histogram of PCs
   bool checkpointing_enabled;
   std::string checkpoint_file;
+  checkpoint_writer_t* chkpt_writer; // writes queued checkpoints (NULL: not started)
+  std::string snapshot_dir;
+  uint64_t snapshot_interval; // cycles between timing snapshots (0: none)
+  uint64_t next_snapshot;     // cycle of the next timing snapshot
 
 	// presents a prompt for introspection into the simulation
 	void interactive();
@@ -117,17 +158,30 @@ private:
 
   //std::fstream proc_chkpt;
   //std::fstream restore_chkpt;
-  ogzstream proc_chkpt;
+  std::ostringstream htif_chkpt; // HTIF log since init_checkpoint()
+  std::string register_checkpoint();
+  void capture_checkpoint(checkpoint_snapshot_t& snap, bool copy);
+  bool restore_sparse_checkpoint(int fd, const checkpoint_header_t& hdr, const std::string& restore_file);
+  void restore_register_checkpoint(const std::string& regs);
+  void restored_proc_state();
+  void snapshot(snapshot_t& s);
+  processor_t* new_micro_proc(size_t i, mmu_t* mmu);
+
+  // Legacy (gzip) checkpoints.
   igzstream restore_chkpt;
-  void create_memory_checkpoint(std::ostream& memory_chkpt);
   void restore_memory_checkpoint(std::istream& memory_chkpt);
-  void create_register_checkpoint(std::ostream& proc_chkpt);
   void restore_proc_checkpoint(std::istream& proc_chkpt);
+  void share_memory_image(sim_t* from);
+  void map_memory_image(int fd);
+  void flush_mmus();
 
 	friend class htif_isasim_t;
   friend class debug_buffer_t;
 };
 
 extern volatile bool ctrlc_pressed;
+// Set by SIGINT/SIGUSR2: the timing simulation ends at the next cycle
+// boundary, and main() shuts the simulators down (see endSimulation()).
+extern volatile sig_atomic_t end_requested;
 
 #endif
@@ -0,0 +1,87 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <type_traits>
+
+// Timing state snapshot (see sim_t::write_snapshot()).
+//
+// Each timing structure has a snapshot(snapshot_t&) function that either
+// saves or restores it, depending on the direction of the snapshot_t, so
+// that the two cannot drift apart. Plain data is copied as is; pointers are
+// never saved. Sizes and other configuration are check()ed: a snapshot can
+// only be restored by a simulator configured the same way.
+class snapshot_t {
+public:
+	snapshot_t(FILE* fp, bool saving) : fp(fp), save(saving) {}
+
+	bool saving() { return(save); }
+
+	template <class T>
+	void io(T* p, size_t n) {
+	   static_assert(std::is_trivially_copyable<T>::value, "snapshot_t::io() copies plain data only");
+	   size_t done = (save ? fwrite(p, sizeof(T), n, fp) : fread(p, sizeof(T), n, fp));
+	   if (done != n) {
+	      fprintf(stderr, "ERROR: %s the timing snapshot failed.\n", (save ? "Writing" : "Reading"));
+	      exit(-1);
+	   }
+	}
+
+	template <class T>
+	void io(T& x) {
+	   io(&x, 1);
+	}
+
+	template <class T>
+	void io(std::vector<T>& v) {
+	   uint64_t n = v.size();
+	   io(n);
+	   v.resize(n);
+	   if (n)
+	      io(v.data(), n);
+	}
+
+	template <class K, class V>
+	void io(std::map<K,V>& m) {
+	   uint64_t n = m.size();
+	   io(n);
+	   if (save) {
+	      for (auto& kv : m) {
+	         K k = kv.first;
+	         io(k);
+	         io(kv.second);
+	      }
+	   }
+	   else {
+	      m.clear();
+	      for (uint64_t i = 0; i < n; i++) {
+	         K k;
+	         V v;
+	         io(k);
+	         io(v);
+	         m[k] = v;
+	      }
+	   }
+	}
+
+	void check(uint64_t x, const char* what) {
+	   uint64_t saved = x;
+	   io(saved);
+	   if (saved != x) {
+	      fprintf(stderr, "ERROR: The timing snapshot was taken with %s = %" PRIu64 ", but this simulator has %" PRIu64 ".\n",
+	              what, saved, x);
+	      fprintf(stderr, "Resume with the options the snapshot was taken with.\n");
+	      exit(-1);
+	   }
+	}
+
+private:
+	FILE* fp;
+	bool save;
+};
+
+#endif //SNAPSHOT_H
@@ -1,10 +1,33 @@
 #include "stats.h"
 #include "pipeline.h"
 #include "parameters.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <cassert>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+volatile sig_atomic_t live_stats_requests = 0;
+
+// Names of the static counters, indexed by counter ID.
+#define STATS_COUNTER_NAME(name) #name,
+static const char* const static_counter_names[NUM_STATIC_COUNTERS] = {
+  STATS_COUNTER_LIST(STATS_COUNTER_NAME)
+};
+#undef STATS_COUNTER_NAME
 
 stats_t::stats_t(pipeline_t* _proc){
 
   this->proc = _proc;
+  this->phase_counter = INVALID_COUNTER;
+  this->phase_counter_name[0] = '\0';
+  this->live = NULL;
+  this->live_size = 0;
+
+  // Static counters occupy the first NUM_STATIC_COUNTERS slots of the count arrays.
+  for (unsigned int i = 0; i < NUM_STATIC_COUNTERS; i++)
+    new_counter(static_counter_names[i], "proc");
 
   DECLARE_COUNTER(this, cycle_count               ,proc);
   DECLARE_COUNTER(this, commit_count              ,proc);
@@ -149,6 +172,11 @@ stats_t::stats_t(pipeline_t* _proc){
 
 }
 
+stats_t::~stats_t(){
+  if (live)
+    munmap(live, live_size);
+}
+
 void stats_t::set_log_files(FILE* _stats_log,FILE* _phase_log){
   this->stats_log = _stats_log;
   this->phase_log = _phase_log;
@@ -158,52 +186,83 @@ void stats_t::set_phase_interval(const char* name,uint64_t interval)
 {
   std::strcpy(phase_counter_name,name);
   phase_interval = interval;
+  // Phase ticking compares counter IDs, so resolve the name once here.
+  // Counters registered later are resolved in register_counter().
+  phase_counter = lookup_counter(name);
   ifprintf(logging_on,stderr,"Setting phase interval to %s = %lu\n",phase_counter_name,interval);
 }
 
 void stats_t::reset_counters(){
-  std::map<std::string, counter_t*, ltstr>::iterator ctr_iter;
-  for(ctr_iter = counter_map.begin();ctr_iter != counter_map.end(); ctr_iter++){
-    ctr_iter->second->count = 0;
-  }
+  std::fill(count.begin(), count.end(), 0);
 }
 
 void stats_t::reset_phase_counters(){
-  std::map<std::string, counter_t*, ltstr>::iterator ctr_iter;
-  for(ctr_iter = counter_map.begin();ctr_iter != counter_map.end(); ctr_iter++){
-    ctr_iter->second->phase_count = 0;
+  std::fill(phase_count.begin(), phase_count.end(), 0);
+}
+
+void stats_t::repeat_counters(const std::vector<uint64_t>& snapshot, uint64_t n){
+  assert(snapshot.size() == count.size());
+  for (counter_id_t i = 0; i < count.size(); i++) {
+    uint64_t delta = count[i] - snapshot[i];
+    count[i] += delta*n;
+    phase_count[i] += delta*n;
   }
 }
 
-void stats_t::register_counter(const char* name, const char* hierarchy){
+// Allocate a new, unregistered counter slot.
+counter_id_t stats_t::new_counter(const char* name, const char* hierarchy){
+  counter_t c;
+  c.name         = new char[strlen(name)+1];
+  c.hierarchy    = new char[strlen(hierarchy)+1];
+  c.registered   = false;
+  c.valid_phase_counter = false;
+  strcpy(c.name,name);
+  strcpy(c.hierarchy,hierarchy);
+  counter_info.push_back(c);
+  count.push_back(0);
+  phase_count.push_back(0);
+  return (counter_id_t)(counter_info.size() - 1);
+}
 
-  counter_t* c    = new counter_t;
-  c->count        = 0;
-  c->phase_count  = 0;
-  c->name         = new char[strlen(name)+1];
-  c->hierarchy    = new char[strlen(hierarchy)+1];
-  c->valid_phase_counter    = false;
-  strcpy(c->name,name);
-  strcpy(c->hierarchy,hierarchy);
-  counter_map[name] = c;
-  ifprintf(logging_on,stderr,"Counter name %s %s\n",name,hierarchy);
+// Returns the ID of a registered counter, or INVALID_COUNTER.
+counter_id_t stats_t::lookup_counter(const char* name){
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter = counter_map.find(name);
+  return (ctr_iter == counter_map.end()) ? INVALID_COUNTER : ctr_iter->second;
 }
 
-void stats_t::register_phase_counter(const char* name, const char* hierarchy){
-  // If the counter has been declared, mark it as a phase counter
-  if(counter_map.find(name) != counter_map.end()){
-    counter_map[name]->valid_phase_counter = true;
-  } 
-  // If it does not exist, declare it and mark it as a phase counter
-  else {
-    counter_t* c    = new counter_t;
-    c->name         = new char[strlen(name)+1];
-    c->hierarchy    = new char[strlen(hierarchy)+1];
-    c->valid_phase_counter  = true;
-    strcpy(c->name,name);
-    strcpy(c->hierarchy,hierarchy);
-    counter_map[name] = c;
+counter_id_t stats_t::register_counter(const char* name, const char* hierarchy){
+  counter_id_t id = lookup_counter(name);
+
+  if (id == INVALID_COUNTER) {
+    // Static counters already have a slot; anything else gets a new one.
+    for (unsigned int i = 0; i < NUM_STATIC_COUNTERS; i++) {
+      if (!strcmp(name, static_counter_names[i])) {
+        id = i;
+        break;
+      }
+    }
+    if (id == INVALID_COUNTER)
+      id = new_counter(name, hierarchy);
+
+    delete[] counter_info[id].hierarchy;
+    counter_info[id].hierarchy = new char[strlen(hierarchy)+1];
+    strcpy(counter_info[id].hierarchy,hierarchy);
+    counter_info[id].registered = true;
+    counter_map[name] = id;
   }
+
+  if (!strcmp(name, phase_counter_name))
+    phase_counter = id;
+
+  ifprintf(logging_on,stderr,"Counter name %s %s\n",name,hierarchy);
+  return id;
+}
+
+counter_id_t stats_t::register_phase_counter(const char* name, const char* hierarchy){
+  // Declare the counter if it does not exist, and mark it as a phase counter
+  counter_id_t id = register_counter(name, hierarchy);
+  counter_info[id].valid_phase_counter = true;
+  return id;
 }
 
 void stats_t::register_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier){
@@ -255,22 +314,16 @@ void stats_t::register_knob(const char* name, const char* hierarchy, unsigned in
 }
 
 
-void stats_t::update_counter(const char* name,unsigned int inc){
+// Slow path for counters known only by name.
+void stats_t::update_counter(const char* name,int inc){
+  counter_id_t id = lookup_counter(name);
   // If the counter has been declared and initialized
-  if(counter_map.find(name) != counter_map.end()){
-    counter_map[name]->count++;
-    counter_map[name]->phase_count++;
-  }
-  // Tick the phase check mechanism if updating the 
-  // counter on which phases are based on. Normally this
-  // would be commit_count or cycle_count.
-  if(!std::strcmp(name, phase_counter_name)){
-    phase_tick();
-  }
+  if(id != INVALID_COUNTER)
+    update_counter(id, inc);
 }
 
 uint64_t stats_t::get_counter(const char* name){
-  return counter_map[name]->count;
+  return count[lookup_counter(name)];
 }
 
 unsigned int stats_t::get_knob(const char* name){
@@ -278,7 +331,7 @@ unsigned int stats_t::get_knob(const char* name){
 }
 
 void stats_t::phase_tick(){
-  if(counter_map[phase_counter_name]->phase_count >= phase_interval){
+  if(phase_count[phase_counter] >= phase_interval){
     phase_id++;
     update_rates();
     dump_phase_counters();
@@ -293,29 +346,33 @@ void stats_t::phase_tick(){
 void stats_t::update_rates(){
   std::map<std::string, rate_t*, ltstr>::iterator rate_iter;
   for(rate_iter = rate_map.begin();rate_iter != rate_map.end(); rate_iter++){
-    if(counter_map[rate_iter->second->denominator]->count == 0){
+    counter_id_t numerator = lookup_counter(rate_iter->second->numerator);
+    counter_id_t denominator = lookup_counter(rate_iter->second->denominator);
+    assert((numerator != INVALID_COUNTER) && (denominator != INVALID_COUNTER));
+
+    if(count[denominator] == 0){
       rate_iter->second->rate = (double)0.0;
     } else {
       rate_iter->second->rate = rate_iter->second->multiplier*
-                                double(counter_map[rate_iter->second->numerator]->count)/
-                                double(counter_map[rate_iter->second->denominator]->count);
+                                double(count[numerator])/
+                                double(count[denominator]);
     }
 
-    if(counter_map[rate_iter->second->denominator]->phase_count == 0){
+    if(phase_count[denominator] == 0){
       rate_iter->second->phase_rate = (double)0.0;
     } else {
       rate_iter->second->phase_rate = rate_iter->second->multiplier*
-                                      double(counter_map[rate_iter->second->numerator]->phase_count)/
-                                      double(counter_map[rate_iter->second->denominator]->phase_count);
+                                      double(phase_count[numerator])/
+                                      double(phase_count[denominator]);
     }
   }
 }
 
 void stats_t::dump_counters(){
   fprintf(stats_log,"[stats]\n");
-  std::map<std::string, counter_t*, ltstr>::iterator ctr_iter;
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter;
   for(ctr_iter = counter_map.begin();ctr_iter != counter_map.end(); ctr_iter++){
-    fprintf(stats_log,"%s : %" PRIu64 "\n",ctr_iter->second->name, ctr_iter->second->count);
+    fprintf(stats_log,"%s : %" PRIu64 "\n",counter_info[ctr_iter->second].name, count[ctr_iter->second]);
   }
 }
 
@@ -329,10 +386,10 @@ void stats_t::dump_rates(){
 
 void stats_t::dump_phase_counters(){
   fprintf(phase_log,"-------- Phase Counters Phase ID %" PRIu64 "--------\n",phase_id);
-  std::map<std::string, counter_t*, ltstr>::iterator ctr_iter;
+  std::map<std::string, counter_id_t, ltstr>::iterator ctr_iter;
   for(ctr_iter = counter_map.begin();ctr_iter != counter_map.end(); ctr_iter++){
-    if(ctr_iter->second->valid_phase_counter)
-      fprintf(phase_log,"%s : %" PRIu64 "\n",ctr_iter->second->name, ctr_iter->second->phase_count);
+    if(counter_info[ctr_iter->second].valid_phase_counter)
+      fprintf(phase_log,"%s : %" PRIu64 "\n",counter_info[ctr_iter->second].name, phase_count[ctr_iter->second]);
   }
 }
 
@@ -387,3 +444,92 @@ void stats_t::dump_br_histogram(){
     }
   }
 }
+
+void stats_t::snapshot(snapshot_t& s){
+  s.check(counter_info.size(), "stats counters");
+  s.io(phase_count.data(), phase_count.size());
+  s.io(phase_id);
+  measurements(s);
+}
+
+void stats_t::measurements(snapshot_t& s){
+  s.io(count.data(), count.size());
+  s.io(pc_histogram);
+  s.io(br_histogram);
+}
+
+bool stats_t::open_live(const char* file){
+  // The region exports the registered counters, i.e., those in stats.log.
+  std::string names;
+  live_counters.clear();
+  for (auto ctr_iter = counter_map.begin(); ctr_iter != counter_map.end(); ctr_iter++) {
+    live_counters.push_back(ctr_iter->second);
+    names += counter_info[ctr_iter->second].name;
+    names += '\n';
+  }
+
+  size_t names_offset = sizeof(live_stats_t) + live_counters.size() * sizeof(uint64_t);
+  size_t size = names_offset + names.size();
+
+  int fd = open(file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    return false;
+  void* p = MAP_FAILED;
+  if (ftruncate(fd, size) == 0)
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+    return false;
+
+  live = (live_stats_t*)p;
+  live_size = size;
+  memset(live, 0, names_offset);
+  memcpy((char*)live + names_offset, names.data(), names.size());
+  live->version = LIVE_STATS_VERSION;
+  live->pid = getpid();
+  live->num_counters = live_counters.size();
+  live->names_offset = names_offset;
+  live->names_size = names.size();
+  update_live(0, 0);
+  __atomic_store_n(&live->magic, LIVE_STATS_MAGIC, __ATOMIC_RELEASE);
+  return true;
+}
+
+void stats_t::update_live(uint64_t cycle, uint64_t instructions){
+  if (!live)
+    return;
+
+  uint64_t seq = live->seq;
+  __atomic_store_n(&live->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  live->updates++;
+  live->cycle = cycle;
+  live->instructions = instructions;
+  live->ipc = (cycle ? (double)instructions/(double)cycle : 0.0);
+  uint64_t* value = (uint64_t*)(live + 1);
+  for (size_t i = 0; i < live_counters.size(); i++)
+    value[i] = count[live_counters[i]];
+
+  __atomic_store_n(&live->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void stats_t::dump_live(const char* file, uint64_t cycle, uint64_t instructions){
+  std::string temp = std::string(file) + ".tmp";
+  FILE* fp = fopen(temp.c_str(), "w");
+  if (!fp)
+    return;
+
+  fprintf(fp, "[live]\n");
+  fprintf(fp, "cycle : %" PRIu64 "\n", cycle);
+  fprintf(fp, "instructions : %" PRIu64 "\n", instructions);
+  fprintf(fp, "ipc : %2.2f\n", (cycle ? (double)instructions/(double)cycle : 0.0));
+  fprintf(fp, "[stats]\n");
+  for (auto ctr_iter = counter_map.begin(); ctr_iter != counter_map.end(); ctr_iter++)
+    fprintf(fp, "%s : %" PRIu64 "\n", counter_info[ctr_iter->second].name, count[ctr_iter->second]);
+
+  if (fclose(fp) == 0)
+    rename(temp.c_str(), file);
+  else
+    unlink(temp.c_str());
+}
@@ -2,18 +2,93 @@
 #define STATS_H
 
 #include <cinttypes>
+#include <csignal>
 #include <cstring>
 #include <map>
 #include <cstdio>
 #include <string>
+#include <vector>
 
 
 // Statistics related variables and funcions
 
-#define inc_counter(x)  stats->update_counter(#x,1)
+// Every counter that the timing model updates through inc_counter()/counter()
+// must appear in this list. Each entry gets a compile-time ID, ctr_<name>,
+// which indexes the flat count arrays in stats_t directly. Only counters that
+// are also registered (DECLARE_COUNTER) are printed to stats.log.
+#define STATS_COUNTER_LIST(X)       \
+  X(cycle_count)                    \
+  X(commit_count)                   \
+  X(ld_vio_count)                   \
+  X(load_count)                     \
+  X(store_count)                    \
+  X(fp_count)                       \
+  X(branch_count)                   \
+  X(cond_branch_count)              \
+  X(uncond_branch_count)            \
+  X(mispredict_count)               \
+  X(exception_count)                \
+  X(spec_inst_count)                \
+  X(spec_load_count)                \
+  X(spec_store_count)               \
+  X(load_replay_count)              \
+  X(load_miss_count)                \
+  X(store_miss_count)               \
+  X(spec_load_miss_count)           \
+  X(spec_store_miss_count)          \
+  X(store_mhsr_miss_count)          \
+  X(load_mhsr_miss_count)           \
+  X(ld_replay_mhsr_miss_count)      \
+  X(fetched_bundle_count)           \
+  X(fetched_inst_count)             \
+  X(btb_write_count)                \
+  X(bp_write_count)                 \
+  X(ras_read_count)                 \
+  X(ras_write_count)                \
+  X(ctiq_read_count)                \
+  X(ctiq_write_count)               \
+  X(dispatched_bundle_count)        \
+  X(dispatched_inst_count)          \
+  X(dispatched_load_count)          \
+  X(dispatched_store_count)         \
+  X(issued_bundle_count)            \
+  X(issued_inst_count)              \
+  X(retired_bundle_count)           \
+  X(retired_inst_count)             \
+  X(lane0_inst_executed_count)      \
+  X(lane1_inst_executed_count)      \
+  X(lane2_inst_executed_count)      \
+  X(lane3_inst_executed_count)      \
+  X(lane4_inst_executed_count)      \
+  X(lane5_inst_executed_count)      \
+  X(lane6_inst_executed_count)      \
+  X(lane7_inst_executed_count)      \
+  X(prf_read_count)                 \
+  X(prf_write_count)                \
+  X(rmt_write_count)                \
+  X(amt_write_count)                \
+  X(recovery_count)                 \
+  X(wakeup_cam_read_count)          \
+  X(freelist_write_count)
+
+// Counter handle. Static counters use the ctr_<name> IDs below; counters
+// registered at run time by name (e.g., per-cache counters) are assigned
+// IDs starting at NUM_STATIC_COUNTERS.
+typedef unsigned int counter_id_t;
+
+#define STATS_COUNTER_ID(name) ctr_##name,
+enum static_counter_t {
+  STATS_COUNTER_LIST(STATS_COUNTER_ID)
+  NUM_STATIC_COUNTERS
+};
+#undef STATS_COUNTER_ID
+
+#define INVALID_COUNTER ((counter_id_t)-1)
+
+#define inc_counter(x)  stats->update_counter(ctr_##x,1)
 #define inc_counter_str(x)  stats->update_counter(x,1)
-#define dec_counter(x)  stats->update_counter(#x,-1)
-#define counter(x)      stats->get_counter(#x)
+#define dec_counter(x)  stats->update_counter(ctr_##x,-1)
+#define counter(x)      stats->get_counter(ctr_##x)
 #define knob(x)         stats->get_knob(#x)
 
 // Macro has been written this way to swallow semicolon
@@ -51,16 +126,16 @@
 
 struct ltstr
 {
-    bool operator()(std::string s1, std::string s2) const {
+    bool operator()(const std::string& s1, const std::string& s2) const {
         return strcmp(s1.c_str(), s2.c_str()) < 0;
     }
 };
 
+// Per-counter metadata. The counts themselves live in stats_t's flat arrays.
 typedef struct counter {
-  uint64_t count;
-  uint64_t phase_count;
   char* name;
   char* hierarchy;
+  bool registered;            // When "true", indicates this is dumped to stats.log
   bool valid_phase_counter;   // When "true", indicates this must be dumped for each phase
 } counter_t;
 
@@ -87,22 +162,65 @@ typedef struct branch {
   size_t mispredicted;
 } branch_t;
 
+// Live statistics region (--livestats). A file that monitoring tools map
+// and read while the simulation runs: this header, then num_counters
+// uint64_t counter values, then the counter names (one per line, in the same
+// order) at names_offset. The simulator never waits for readers: 'seq' is a
+// sequence lock, odd while an update is in progress, so a reader copies what
+// it needs and retries if 'seq' was odd or changed in the meantime.
+#define LIVE_STATS_MAGIC   0x5354534556494c37ULL  // "7LIVESTS"
+#define LIVE_STATS_VERSION 1
+
+typedef struct live_stats {
+  uint64_t magic;
+  uint64_t version;
+  volatile uint64_t seq;
+  uint64_t pid;
+  uint64_t updates;           // Number of updates so far
+  uint64_t cycle;
+  uint64_t instructions;
+  double ipc;
+  uint64_t num_counters;
+  uint64_t names_offset;
+  uint64_t names_size;
+} live_stats_t;
+
+// Count of live statistics requests (SIGUSR1) so far.
+extern volatile sig_atomic_t live_stats_requests;
+
 //Forward declaring classes
 class pipeline_t;
+class snapshot_t;
 
 class stats_t {
 public:
 
   stats_t(pipeline_t* _proc);
-  ~stats_t(){}
+  ~stats_t();
   void set_phase_interval(const char* name,uint64_t interval);
-  void update_counter(const char* name,unsigned int inc=1);
+  void update_counter(const char* name,int inc=1);
   void update_pc_histogram(size_t pc);
   void update_br_histogram(size_t pc,bool misp);
   uint64_t get_counter(const char* name);
   unsigned int get_knob(const char* name);
-  void register_counter(const char* name, const char* hierarchy);
-  void register_phase_counter(const char* name, const char* hierarchy);
+  counter_id_t register_counter(const char* name, const char* hierarchy);
+  counter_id_t register_phase_counter(const char* name, const char* hierarchy);
+  counter_id_t lookup_counter(const char* name);
+
+  // Hot path: counters are updated through their integer handle.
+  inline void update_counter(counter_id_t id, int inc=1) {
+    count[id] += inc;
+    phase_count[id] += inc;
+    // Tick the phase check mechanism if updating the
+    // counter on which phases are based on. Normally this
+    // would be commit_count or cycle_count.
+    if (id == phase_counter)
+      phase_tick();
+  }
+
+  inline uint64_t get_counter(counter_id_t id) {
+    return count[id];
+  }
   void register_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier);
   void register_phase_rate(const char* name, const char* hierarchy, const char* numerator, const char* denominator, double multiplier);
   void register_knob(const char* name, const char* hierarchy, unsigned int value);
@@ -110,6 +228,11 @@ public:
 
   void reset_counters();
   void reset_phase_counters();
+
+  // Idle-cycle fast-forward: apply the counter increments made since 'snapshot' another 'n' times.
+  void snapshot_counters(std::vector<uint64_t>& snapshot) { snapshot = count; }
+  void repeat_counters(const std::vector<uint64_t>& snapshot, uint64_t n);
+  bool phase_counting() { return (phase_counter != INVALID_COUNTER); }
   void update_rates();
   void dump_counters();  
   void dump_phase_counters();  
@@ -119,11 +242,29 @@ public:
   void dump_pc_histogram();  
   void dump_br_histogram();  
 
+  // Live statistics: the region is created by open_live() (once all counters
+  // are registered) and refreshed by update_live(); dump_live() writes the
+  // same snapshot as text, replacing 'file' atomically.
+  bool open_live(const char* file);
+  void update_live(uint64_t cycle, uint64_t instructions);
+  void dump_live(const char* file, uint64_t cycle, uint64_t instructions);
+
+  // Timing snapshots: save or restore the counters and histograms.
+  void snapshot(snapshot_t& s);
+  // Sampling: save or restore the measurements only (not the phase counters).
+  void measurements(snapshot_t& s);
+
   //inline void set_histogram(bool val){histogram_enabled = val;}
 
 private:
 
-  std::map<std::string, counter_t*, ltstr> counter_map;
+  // Indexed by counter ID.
+  std::vector<uint64_t> count;
+  std::vector<uint64_t> phase_count;
+  std::vector<counter_t> counter_info;
+
+  // Registered counters only, sorted by name for dumping and string lookups.
+  std::map<std::string, counter_id_t, ltstr> counter_map;
   std::map<std::string, rate_t*, ltstr> rate_map;
   //map<const char*, counter_t*, ltstr> phase_counter_map;
   std::map<std::string, knob_t*, ltstr> knob_map;
@@ -133,13 +274,19 @@ private:
   uint64_t phase_id;
   uint64_t phase_interval;
   char phase_counter_name[16];
+  counter_id_t phase_counter;   // ID of phase_counter_name, or INVALID_COUNTER
   FILE* stats_log;
   FILE* phase_log;
 
   pipeline_t* proc;
   //bool histogram_enabled;
 
+  live_stats_t* live;         // Live statistics region (NULL: none)
+  size_t live_size;
+  std::vector<counter_id_t> live_counters;  // Counters in the region, in order
+
   void phase_tick();
+  counter_id_t new_counter(const char* name, const char* hierarchy);
 };
 
 #endif //STATS_H